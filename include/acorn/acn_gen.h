@@ -16,9 +16,9 @@ extern "C" {
 
 /* Macros to set instruction fields. */
 
-/** Set a specific byte position in the byte-code instruction */
+/** Change a specific byte position (0=least significant) in the byte-code instruction */
 #define setbc_byte(p, x, ofs) \
-  ((uint8_t *)(p))[LJ_ENDIAN_SELECT(ofs, 3-ofs)] = (uint8_t)(x)
+	(((p) & ~(((Instruction)0xff)<<((ofs)*8))) | (((Instruction)(uint8_t)(x))<<((ofs)*8)))
 #define setbc_op(p, x)	setbc_byte(p, (x), 0) //!< Change the instruction's op code
 #define setbc_a(p, x)	setbc_byte(p, (x), 1) //!< Change the instruction's A byte
 #define setbc_b(p, x)	setbc_byte(p, (x), 3) //!< Change the instruction's B byte
@@ -32,6 +32,8 @@ extern "C" {
   (((BCIns)(o))|((BCIns)(a)<<8)|((BCIns)(b)<<24)|((BCIns)(c)<<16)) //!< Build an ABC-based instruction
 #define BCINS_ABx(o, a, bx) \
   (((BCIns)(o))|((BCIns)(a)<<8)|((uint16_t)(bx)<<16)) //!< Build an ABx-based instruction
+#define BCINS_Ax(o, ax) \
+  (((BCIns)(o))|((Instruction)(ax)<<8)) //!< Build an Ax-based instruction
 #define BCINS_AJ(o, a, j)	BCINS_ABx(o, a, ((int16_t)(j)+BCBIAS_J)) //!< Build a jump instruction
 
 // ***********
@@ -44,6 +46,8 @@ void genPutInstr(CompInfo *comp, AuintIdx loc, Instruction i);
 void genAddInstr(CompInfo *comp, Instruction i);
 /** Add a literal and return its index */
 int genAddLit(CompInfo *comp, Value val);
+/** Add a global variable's bound cell as a literal and return its index */
+int genAddGlobal(CompInfo *comp, Value var);
 /** Indicate the method has a variable number of parameters */
 void genVarParms(CompInfo *comp);
 /** Raise method's max stack size if register is above it */
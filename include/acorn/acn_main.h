@@ -45,6 +45,7 @@ typedef struct LexInfo {
 	unsigned int newindent; //!< Indentation level for current line
 
 	int optype;			//!< sub-type of operator (when type==Op_Token)
+	signed char opredef;	//!< 1 if source names an operator the optimizer might fold (-1 if not yet known)
 	TokenType toktype;	//!< type of the current token
 	bool newline;		//!< True if we just started a new non-continued line
 	bool newprogram;	//!< True if we have not yet processed any token
@@ -83,6 +84,7 @@ typedef struct CompInfo {
 	unsigned int thisopreg;	//!< Register for method to use on every 'this' block stmt
 	int whileBegIp;			//!< ip of current while block's first instruction
 	int whileEndIp;			//!< ip of first jump statement to end of current while block
+	int whileContIp;		//!< ip of first 'continue' jump forward to end of current for block
 
 	bool forcelocal;		//!< true if undeclared local must be local
 	bool explicitclo;		//!< True if we are within an explicit closure
@@ -131,6 +133,9 @@ void newBMethod(Value th, Value *dest);
 /** Parse an Acorn program */
 void parseProgram(CompInfo* comp);
 
+/** Optimize a parsed Acorn method's AST, folding constant expressions and dropping unreachable clauses */
+void optProgram(CompInfo *comp);
+
 /** Generate a complete byte-code method by walking the 
  * Abstract Syntax Tree generated by the parser */
 void genBMethod(CompInfo *comp);
@@ -207,6 +207,8 @@ AVM_API Value pushCloVar(Value th, AuintIdx idx);
 AVM_API void popCloVar(Value th, AuintIdx idx);
 /** Push and return a new Table value */
 AVM_API Value pushTbl(Value th, Value type, AuintIdx size);
+/** Push and return a new Table value whose Text keys match by content (like Symbols), not identity */
+AVM_API Value pushTextTbl(Value th, Value type, AuintIdx size);
 /** Push and return a new Type value */
 AVM_API Value pushType(Value th, Value type, AuintIdx size);
 /*^ Push and return a new Mixin value */
@@ -0,0 +1,59 @@
+/** Translates hot bytecode methods to native x86-64 code.
+ *
+ * Once a bytecode method's calls plus loop iterations reach the VM's jit threshold,
+ * its code is translated, instruction by instruction, into native code using a
+ * fixed template for each opcode. Loads, global reads, jumps, Integer arithmetic and
+ * compare-and-branch run natively; Float arithmetic and comparisons call small C helpers.
+ *
+ * Native code never changes call frames, threads or the stack top. Any instruction
+ * that would (calls, property access, returns, yields, etc.) or any slow path (such as
+ * calling an operator method) hands control back to methodRunBC at that instruction.
+ * The interpreter re-enters native code when a method starts and on each loop back-edge.
+ * Because of this, CallInfo, stk_top and yielder handling stay entirely with the interpreter.
+ *
+ * @file
+ *
+ * This source file is part of avm - Acorn Virtual Machine.
+ * See Copyright Notice in avm.h
+*/
+
+#ifndef avm_jit_h
+#define avm_jit_h
+
+#include "avm/avm_method.h"
+
+#ifdef __cplusplus
+namespace avm {
+extern "C" {
+#endif
+
+/** A bytecode method's native translation */
+typedef struct JitCode {
+	unsigned char *native;	//!< Executable native code (NULL if the method could not be translated)
+	Auint nativesz;			//!< Size of memory mapped for native code
+	Auint *offsets;			//!< Where each instruction's native code starts (one extra for end of code)
+	AuintIdx nbroffsets;	//!< Number of offsets
+} JitCode;
+
+/** Native code's entry point: stkbeg and lits are those of the current frame, start is where to begin.
+ * It returns the instruction the interpreter is to perform next. */
+typedef Instruction *(*JitEntryp)(Value th, Value *stkbeg, Value *lits, unsigned char *start);
+
+/** Translate a method's bytecode to native code, returning its JitCode.
+ * If it cannot be translated, JitCode's native is NULL (and it will not be tried again). */
+JitCode *jitCompile(Value th, BMethodInfo *meth);
+
+/** Free a method's native code */
+void jitFree(Value th, BMethodInfo *meth);
+
+/** Run method's native code from instruction ip, returning the next instruction for the interpreter */
+#define jitRun(th, meth, stkbeg, ip) \
+	(((JitEntryp)(meth)->jit->native)(th, stkbeg, (meth)->lits, \
+		(meth)->jit->native + (meth)->jit->offsets[(ip)-(meth)->runcode]))
+
+#ifdef __cplusplus
+} // end "C"
+} // end namespace
+#endif
+
+#endif
@@ -147,6 +147,10 @@ enum EncType {
 
 /** Initialize memory and garbage collection for VM */
 void mem_init(struct VmInfo* vm);
+/** Allocate the VM's nursery, with every block empty */
+void mem_nurseryinit(struct VmInfo* vm);
+/** Free the VM's nursery */
+void mem_nurseryclose(struct VmInfo* vm);
 
 /** Create a new variable-sized object (with given encoding and size) and add to front of *list. */
 MemInfo *mem_new(Value th, int enc, Auint sz);
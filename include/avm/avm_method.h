@@ -47,6 +47,9 @@ typedef struct MethodInfo {
 #define METHOD_FLG_C			0x40 //!< The method is coded in C (vs. Bytecode)
 #define METHOD_FLG_VARPARM		0x20 //!< The method accepts a variable number of parameters
 #define METHOD_FLG_YIELDER		0x10 //!< Method call creates a yielder
+#define METHOD_FLG_VERIFIED		0x08 //!< Bytecode has passed methodVerify, so it may be run
+#define METHOD_FLG_FASTCALL		0x04 //!< Verified bytecode with fixed parameters, called via callBCFastPrep
+#define METHOD_FLG_STACKLESS	0x02 //!< Yielder method whose yielders run on their caller's thread (see newYielder)
 
 /** Is the value a method? */
 #define isMethod(val) (isEnc(val, MethEnc))
@@ -140,6 +143,7 @@ enum ByteCodeOps {
 	OpSetGlobal,
 	OpGetClosure,
 	OpSetClosure,
+	OpNewClosure,
 	OpJump,
 	OpJNull,
 	OpJNNull,
@@ -173,12 +177,53 @@ enum ByteCodeOps {
 	OpEachPrep,
 	OpEachSplat,
 	OpEachCall,
+	OpForPrep,
+	OpForLoop,
+	OpSwitch,
+	OpAdd,
+	OpSub,
+	OpMul,
+	OpDiv,
+	OpRocket,
+	OpLoadLitReg,
+
+	// Quickened forms of the above, which only appear in runcode (see methodRunBC)
+	OpAddInt,
+	OpAddFloat,
+	OpSubInt,
+	OpSubFloat,
+	OpMulInt,
+	OpMulFloat,
+	OpDivInt,
+	OpDivFloat,
+	OpRocketInt,
+	OpRocketFloat,
+	OpEachList,
+	OpEachRange,
+	OpEachIndex,
+	OpEachText,
+	OpForLoopInt,
+	OpForLoopFloat,
 };
 
+/** Inline cache of property lookups at one call site (OpGetCall, OpGetProp or OpGetActProp).
+ * Each entry remembers the property value found for a receiver's type and property symbol.
+ * The whole cache is stale once the VM's type epoch has moved on. */
+typedef struct PropCache {
+	uint64_t epoch;			//!< VM's type epoch when entries were cached
+	AuintIdx nbrentries;	//!< Number of entries in use
+	struct {
+		Value type;			//!< Receiver's type
+		Value sym;			//!< Property symbol
+		Value val;			//!< Property's value
+	} entry[AVM_PROPCACHESIZE];
+} PropCache;
+
 /** Information about a bytecode method */
 typedef struct BMethodInfo {
 	MemCommonInfoMeth;			//!< Common method header
 	Instruction *code;		//!< Array of bytecode instructions (size is nbr of instructions)
+	Instruction *runcode;	//!< Verified copy of code that is run, rewritten as it runs
 	Value *lits;			//!< Array of literals used by this method
 	AuintIdx avail;			//!< nbr of Instructions code is allocated for
 	AuintIdx litsz;			//!< Allocated size of literal list
@@ -186,6 +231,10 @@ typedef struct BMethodInfo {
 	AuintIdx nbrexterns;	//!< Number of externals in lits
 	AuintIdx nbrlocals;		//!< Number of local variables in locals
 	AuintIdx maxstacksize;	//!< Maximum size of stack needed to parms+locals
+	PropCache *propcache;	//!< Inline property caches, one per call site
+	AuintIdx nbrpropcache;	//!< Number of property caches
+	struct JitCode *jit;	//!< Native translation of code, once method is hot (see avm_jit.h)
+	Auint jithits;			//!< Calls and loop iterations counted toward translation
 } BMethodInfo;
 
 /** Mark all Func values for garbage collection 
@@ -194,6 +243,15 @@ typedef struct BMethodInfo {
 	{if (!isCMethod(m) && ((BMethodInfo*)m)->nbrlits>0) \
 		for (AuintIdx i=0; i<((BMethodInfo*)m)->nbrlits; i++) \
 			mem_markobj(th, ((BMethodInfo*)m)->lits[i]); \
+	if (!isCMethod(m)) \
+		for (AuintIdx i=0; i<((BMethodInfo*)m)->nbrpropcache; i++) { \
+			PropCache *pc = &((BMethodInfo*)m)->propcache[i]; \
+			for (AuintIdx j=0; j<pc->nbrentries; j++) { \
+				mem_markobj(th, pc->entry[j].type); \
+				mem_markobj(th, pc->entry[j].sym); \
+				mem_markobj(th, pc->entry[j].val); \
+			} \
+		} \
 	}
 
 /** Free all of an part's allocated memory */
@@ -202,7 +260,10 @@ typedef struct BMethodInfo {
 	else {\
 		BMethodInfo* bm = (BMethodInfo*)m; \
 		if (bm->code) mem_freearray(th, bm->code, bm->avail); \
+		if (bm->runcode) mem_freearray(th, bm->runcode, bm->size); \
 		if (bm->lits) mem_freearray(th, bm->lits, bm->litsz); \
+		if (bm->propcache) mem_freearray(th, bm->propcache, bm->nbrpropcache); \
+		if (bm->jit) jitFree(th, bm); \
 		mem_free(th, bm); \
 	}}
 
@@ -234,6 +295,11 @@ enum MethodTypes {
  */
 MethodTypes callMorCPrep(Value th, Value *methodval, int nexpected, int flags);
 
+/** Prepare call from bytecode to a bytecode method flagged METHOD_FLG_FASTCALL.
+ * It does what callMorCPrep would, skipping all checks and parameter adjustments
+ * such a method cannot need. Always returns MethodBC. */
+MethodTypes callBCFastPrep(Value th, Value *methodval, int nexpected, int flags);
+
 /** Prepare call to yielder value on stack (with parms above it). 
  * Specify how many return values to expect to find on stack.
  * Flags is 0 for normal get, 1 for set, and 2 for repeat get
@@ -247,9 +313,20 @@ MethodTypes callMorCPrep(Value th, Value *methodval, int nexpected, int flags);
  */
 MethodTypes callYielderPrep(Value th, Value *methodval, int nexpected, int flags);
 
+/** Prepare call to a stackless yielder value on stack (with parms above it),
+ * resuming its frame on this thread. Returns MethodBC. */
+MethodTypes callStacklessPrep(Value th, Value *methodval, int nexpected, int flags);
+
 /** Execute byte-code method pointed at by thread's current call frame */
 void methodRunBC(Value th);
 
+/** Get self's property value, using (and refreshing) a call site's inline property cache */
+Value methGetPropCached(Value th, BMethodInfo *meth, PropCache *pc, Value self, Value sym);
+
+/** Verify that a bytecode method's instructions are safe to run without checks.
+ * On success, the method is marked as verified and true is returned. */
+bool methodVerify(Value th, Value meth);
+
 /** Serialize an method's bytecode contents to indented text */
 void methSerialize(Value th, Value str, int indent, Value arr);
 
@@ -37,6 +37,7 @@ typedef struct StrInfo {
 	MemCommonInfoT;	//!< Common header for typed value
 	char *str;		//!< Pointer to allocated buffer for bytes
 	AuintIdx avail;	//!< Allocated size of character buffer
+	AuintIdx hash;	//!< Hash of its contents, cached by str_hash (0 until calculated)
 } StrInfo;
 
 // Flags1 bits and helpers -->
@@ -82,6 +83,11 @@ typedef int (*CDataFinalizerFn)(Value o);
 /** Return the length of the string's bytes (without 0-terminator) */
 #define str_size(val) (str_info(val)->size)
 
+/** Calculates the number of UTF-8 bytes used to encode the Unicode code point pointed at by textp */
+#define utf8_charsize(textp) \
+	((*textp&0x80) == 0x00? (*textp? 1 : 0) : \
+	(*textp&0xE0) == 0xC0? 2 : (*textp&0xF0) == 0xE0? 3 : 4)
+
 // ***********
 // Non-API String functions
 // ***********
@@ -94,9 +100,13 @@ Value newStr(Value th, Value *dest, Value type, const char *str, AuintIdx len);
 	Its type may have a _finalizer, called just before the GC frees the C-Data value. */
 Value newCData(Value th, Value *dest, Value type, unsigned char cdatatyp, AuintIdx len, unsigned int extrahdr);
 
-/** Calculate the hash value for a string */
+/** Return the hash of a string's contents, calculating it only the first time.
+ * Changing the contents (e.g., strSub or strAppend) forgets it. */
 AuintIdx str_hash(Value th, Value val);
 
+/** Like str_hash, for callers without a thread, which pass the VM's hashseed */
+AuintIdx str_seedhash(Value val, AuintIdx seed);
+
 #ifdef __cplusplus
 } // end "C"
 } // end namespace
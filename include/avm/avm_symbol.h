@@ -49,25 +49,56 @@ typedef struct SymInfo {
 /** Return the length of the symbol's string (without 0-terminator) */
 #define sym_size(val) (sym_info(val)->size)
 
+/** Marks a symbol table slot whose symbol was removed (never dereferenced) */
+#define SymDeleted ((SymInfo*) 1)
+
+/** Return true if a symbol table slot holds a symbol */
+#define sym_isused(sym) ((Auint)(sym) > (Auint) SymDeleted)
+
+/** One symbol table slot: the symbol and a copy of its hash,
+ * so that probing rarely has to look at the symbol itself */
+typedef struct SymSlot {
+	SymInfo *sym;		//!< Symbol (NULL if never used, SymDeleted if removed)
+	AuintIdx hash;		//!< Symbol's hash
+} SymSlot;
+
 /** Symbol table structure. 
- * There is only one symbol table used to index all symbols. Its array will double in size
- * when empty space gets tight. The symbol table is simply a collection of symbol Values,
- * indexed by the symbol's hash value. Since different symbols can hash to the same index, 
- * one may need to follow the Value forward-link chain to find the desired symbol. */
+ * There is only one symbol table used to index all symbols. It is an open-addressed
+ * array of slots, probed linearly from the slot picked by the symbol's hash.
+ * When it gets too full, a new array (usually double the size) replaces it, but symbols
+ * are moved over from the old array incrementally, a few each time a symbol is added.
+ * Until then, a symbol may be found in either array.
+ * Slots are numbered across both arrays (old first) for incremental sweeping.
+ * Symbols added since the last sweep began are also listed in young, so that a
+ * generational collection only has to sweep those (all others are old). */
 struct SymTable {
-	SymInfo **symArray; /**< Array of symbol pointers */
-	Auint nbrAvail; /**< Number of allocated table entries */
-	Auint nbrUsed;  /**< Number of table entries in use */
+	SymSlot *symArray;	/**< Array of symbol slots */
+	SymSlot *oldArray;	/**< Array whose symbols are being moved to symArray (or NULL) */
+	Auint nbrAvail;		/**< Number of allocated slots in symArray */
+	Auint nbrUsed;		/**< Number of symbols in the table */
+	Auint nbrDeleted;	/**< Number of removed symbols' slots in symArray */
+	Auint oldAvail;		/**< Number of allocated slots in oldArray (0 if none) */
+	Auint oldMoved;		/**< Number of oldArray's slots already moved */
+	SymInfo **young;	/**< Symbols added since the last sweep began */
+	AuintIdx nbrYoung;	/**< Number of symbols in young */
+	AuintIdx availYoung;	/**< Number of allocated entries in young */
 };
 
+/** Number of slots across the symbol table's arrays */
+#define sym_nbrslots(tbl) ((tbl)->oldAvail + (tbl)->nbrAvail)
+
+/** Point to the symbol table slot at a position across both arrays */
+#define sym_slot(tbl, pos) \
+	((pos) < (tbl)->oldAvail? &(tbl)->oldArray[pos] : &(tbl)->symArray[(pos) - (tbl)->oldAvail])
+
 /** Memory size of symbol table - used by garbage collector */
 #define sym_tblsz(th) \
-	(sizeof(SymTable) + vm(th)->sym_table.nbrAvail * sizeof(SymInfo*))
+	(sizeof(SymTable) + sym_nbrslots(&vm(th)->sym_table) * sizeof(SymSlot))
 
-/** After deleting unused symbols, shrink symbol table by half, if using less than half of it */
+/** After deleting unused symbols, shrink symbol table by half, if using less than a quarter of it */
 #define sym_tblshrinkcheck(th) \
 	{Auint hs = vm(th)->sym_table.nbrAvail >> 1; \
-	if (vm(th)->sym_table.nbrUsed < hs) \
+	if (vm(th)->sym_table.oldArray == NULL && hs >= AVM_SYMTBLMINSIZE && vm(th)->sym_table.nbrUsed < (hs >> 1)) \
 		sym_resize_tbl(th, hs);}
 
 
@@ -79,8 +110,10 @@ struct SymTable {
 void sym_init(Value th);
 /** Free the symbol table */
 void sym_free(Value th);
-/** Resize the symbol table */
+/** Start moving the symbol table's symbols to a new array of newsize slots */
 void sym_resize_tbl(Value th, Auint newsize);
+/** Return the symbol table slot holding the symbol */
+SymSlot *sym_slotof(Value th, SymInfo *sym);
 
 /** If symbol exists in symbol table, reuse it. Otherwise, add it. 
    Anchor (store) symbol value in dest and return it. */
@@ -19,6 +19,21 @@
  * The Table's key-value pair is essentially a property. 
  * The Table structure is critical for storing methods & global variables.
  *
+ * A Type or object (see newType) starts out "shaped": its Symbol keys are kept in a Shape
+ * shared by all tables that added the same keys in the same order, and its values in a
+ * compact slot vector. It switches for good to a hashed index (dictionary mode) once a key
+ * is removed, a non-Symbol key is added or it outgrows AVM_SHAPEMAXKEYS keys.
+ *
+ * The hashed index is a chained scatter table of Nodes, or, where AVM_SWISSTABLE is defined,
+ * an open-addressed array of key/value entries probed 16 one-byte control tags at a time.
+ *
+ * Text keys normally match by identity, like other objects, but a table made by newTextTbl
+ * hashes them by contents (cached in the Text) and matches equal contents as one key.
+ *
+ * A table not shaped also has an array part: a vector holding the values of Integer keys
+ * 0 up to its size. It is sized whenever the hashed index fills up, to the largest power of 2
+ * that would be more than half used. All other keys live in the hashed index.
+ *
  * Tables are mutable; their content and size can be changed as needed.
  * Increases in size often requires allocating a larger block and copying the contents.
  * To minimize this, size it properly at creation or resize it using large increments.
@@ -51,39 +66,82 @@ typedef struct Node {
 	struct Node *next;  //!< Link to next node with same hash
 } Node;
 
+/** Structure of a Swiss-table index entry (AVM_SWISSTABLE). Its control byte tells whether it is in use. */
+typedef struct TblEntry {
+	Value key;			//!< Entry's key
+	Value val;			//!< Entry's value
+} TblEntry;
+
+/** Flattened cache of property lookups by users of a Type (see getProperty), misses included.
+ * An entry's slot is picked by its property symbol's hash.
+ * The whole cache is stale once the VM's type epoch has moved on, which writes to
+ * instances do not do: only changes to inheritance or to searched Types (see CachedTbl). */
+typedef struct TypeCache {
+	uint64_t epoch;			//!< VM's type epoch when entries were cached
+	struct {
+		Value sym;			//!< Property symbol (aNull if unused)
+		Value val;			//!< Property's value, found anywhere up the inheritance (aNull if none)
+	} entry[AVM_TYPECACHESIZE];
+} TypeCache;
+
+/** A hidden class: the Symbol keys, in slot order, shared by every shaped table
+ * that added the same keys in the same order. Shapes form a tree rooted in the VM's
+ * empty shape, each child adding one more key. They belong to the VM until it closes. */
+typedef struct Shape {
+	struct Shape *parent;	//!< Shape before the last key was added (NULL for the root)
+	struct Shape **trans;	//!< Cached transitions: child shapes, each adding one more key
+	Value *keys;			//!< All keys, in slot order
+	AuintIdx nkeys;			//!< Number of keys (and of slots in use)
+	AuintIdx ntrans;		//!< Number of transitions
+	AuintIdx availtrans;	//!< Allocated size of trans
+} Shape;
+
 /** Information about an table information block. (uses MemCommonInfoT) 
- * Note that flags2 is used to indicate the log2 of size of 'nodes' buffer */
+ * Note that flags2 is used to indicate the log2 of size of 'nodes' (or 'slots') buffer */
 typedef struct TblInfo {
 	MemCommonInfoT;				//!< Common header for typed value
-	struct Node *nodes;			//!< Pointer to allocated table index
-	struct Node *lastfree;		//!< any free node in index is before this position
+	union {
+		struct Node *nodes;		//!< Pointer to allocated table index (dictionary mode)
+		struct TblEntry *entries;	//!< Pointer to allocated table index (dictionary mode, AVM_SWISSTABLE)
+		Value *slots;			//!< Values in the order of the shape's keys (shaped mode)
+	};
+	union {
+		struct Node *lastfree;	//!< any free node in index is before this position
+		signed char *ctrl;		//!< Control byte for each entry: its key's hash tag, or empty/deleted (AVM_SWISSTABLE)
+	};
 	Value inheritype;			//!< pointer to more properties for users of this type
+	struct TypeCache *propcache;	//!< Resolved property lookups for users of this type (or NULL)
+	struct Shape *shape;		//!< Shared keys for the values in slots (NULL in dictionary mode)
+	Value *array;				//!< Values of Integer keys 0 to arraysize-1, aNoVal if absent (or NULL)
+	AuintIdx arraysize;			//!< Number of values in the array part
+	AuintIdx hashseed;			//!< VM's seed for hashing Text keys (TextKeyTbl only), for lookups made without a thread
+#ifdef AVM_SWISSTABLE
+	AuintIdx growth;			//!< Empty entries that may still be filled before the index is rebuilt
+#endif
 } TblInfo;
 
-/** flags2 holds log2 of available number of nodes in 'node' buffer */
+/** Marks an absent key in a table's array part (never a Value anywhere else) */
+#define aNoVal ((Value) ((3 << ValShift) + ValCons))
+
+/** flags2 holds log2 of available number of nodes in 'node' (or 'slots') buffer */
 #define lAvailNodes flags2
 
 /* flags1 flags */
 // 0x80 reserved for Locked
 #define TypeTbl 0x40	//!< Flags1 bit, if table is for a Type (members are properties)
 #define ProtoType 0x20	//!< Flags1 bit, if uses own properties and inheritype == type
+#define GlobalTbl 0x10	//!< Flags1 bit, if table's values are mirrored in bound global variable cells
+#define TextKeyTbl 0x08	//!< Flags1 bit, if Text keys are hashed and matched by content (see newTextTbl)
+#define CachedTbl 0x04	//!< Flags1 bit, once a property lookup (whose result caches keep) has searched this Type
 
-/** Mark all in-use table values for garbage collection 
- * Increments how much allocated memory the table uses. */
-#define tblMark(th, t) \
-	{mem_markobj(th, (t)->type); \
-	mem_markobj(th, (t)->inheritype); \
-	for (Node *n = &(t)->nodes[((1<<(t)->lAvailNodes))-1]; n >= (t)->nodes; n--) \
-		if (n->key != aNull) { \
-			mem_markobj(th, n->key); \
-			mem_markobj(th, n->val); \
-		}}
-
-/** Free all of an array's allocated memory */
-#define tblFree(th, t) \
-	{if ((t)->nodes  != &emptyNode) \
-		mem_freearray(th, (t)->nodes, 1<<(t)->lAvailNodes); \
-	mem_free(th, (t));}
+/** Return true if the key is a Text value that a table marked TextKeyTbl matches by content */
+#define tblIsTextKey(t, key) \
+	(((t)->flags1 & TextKeyTbl) && isEnc(key, StrEnc) && !(str_info(key)->flags1 & StrCData))
+
+/** Return true if two keys are the same key in the table:
+ * the same value, or (for a TextKeyTbl) Text values with the same contents */
+#define tblKeyEq(t, key1, key2) \
+	((key1)==(key2) || (tblIsTextKey(t, key1) && tblTextEq(key1, key2)))
 
 /** Point to table information, by recasting a Value pointer */
 #define tbl_info(val) (assert_exp(isEnc(val,TblEnc), (TblInfo*) (val)))
@@ -95,11 +153,25 @@ typedef struct TblInfo {
 // Non-API Table functions
 // ***********
 
-extern const struct Node emptyNode;
+/** Mark all in-use table values for garbage collection
+ * Increments how much allocated memory the table uses. */
+void tblMark(Value th, TblInfo *t);
+
+/** Free all of a table's allocated memory */
+void tblFree(Value th, TblInfo *t);
 
 /** Create and initialize a new hash table with room for size entries */
 Value newTbl(Value th, Value *dest, Value type, AuintIdx size);
 
+/** Create and initialize a new hash table whose Text keys match by content, not identity.
+ * So two Text values with the same contents are one key, as if they were a Symbol,
+ * without filling the symbol table. Changing a Text's contents while it is a key
+ * leaves it lost in the table. */
+Value newTextTbl(Value th, Value *dest, Value type, AuintIdx size);
+
+/** Return true if both keys are Text values with the same contents */
+int tblTextEq(Value key1, Value key2);
+
 /** Create and initialize a new Type (a table where members are properties) */
 Value newType(Value th, Value *dest, Value type, AuintIdx size);
 
@@ -108,9 +180,26 @@ Value newMixin(Value th, Value *dest, Value type, Value inheritype, AuintIdx siz
 
 AuintIdx tblCalcStrHash(const char *str, Auint len, AuintIdx seed);
 
+/** Create the VM's root (empty) shape */
+void tblShapeInit(Value th);
+
+/** Free all the VM's shapes */
+void tblShapeFree(Value th);
+
+/** Move a shaped table's keys and values into a hashed index (dictionary mode), for good */
+void tblDictMode(Value th, Value tbl);
+
+/** Return the Type's cache of property lookups, allocating it or emptying it (if stale) as needed */
+TypeCache *tblTypeCache(Value th, Value type);
+
 /** Return a pointer to the value in the table at key, or NULL if not found. */
 Value *tblGetp(Value tbl, Value key);
 
+/** Find the table's first used node at or after position pos (start at 0),
+ * placing its key and value in *key and *val. Return the position to continue from,
+ * or 0 when no nodes are left. Like tblNext, but without looking up the prior key. */
+AuintIdx tblIterate(Value tbl, AuintIdx pos, Value *key, Value *val);
+
 /** Serialize an table's contents to indented text */
 void tblSerialize(Value th, Value str, int indent, Value tbl);
 
@@ -23,11 +23,9 @@ namespace avm {
 extern "C" {
 #endif
 
-/** A single entry on the thread's call stack */
+/** A single entry on the thread's call stack.
+ * Frames are contiguous, so a frame's caller is the one just below it. */
 typedef struct CallInfo {
-	struct CallInfo *previous;			//!< call stack chain back link
-	struct CallInfo *next;				//!< call stack chain next link
-
 	// Data stack pointers
 	Value *methodbase;					//!< Points to method value, just below varargs
 	Value *retTo;						//!< Where to place return values
@@ -59,7 +57,8 @@ typedef struct ThreadInfo {
 	// Call stack
 	Value yieldTo;			//!< Thread to yield back to
 	CallInfo *curmethod;	//!< Call info for current method
-	CallInfo entrymethod;	//!< Call info for C-method that started this thread
+	CallInfo *calls;		//!< Array of call frames, the first for the C-method that started this thread
+	CallInfo *calls_last;	//!< Points to the highest allocated call frame
 } ThreadInfo;
 
 /* flags1 flags */
@@ -67,6 +66,7 @@ typedef struct ThreadInfo {
 #define ThreadYielder 0x40	//!< Flags1 bit, if thread is a yielder
 #define ThreadThread  0x20	//!< Flags1 bit, if thread is a thread
 #define ThreadDone    0x10	//!< Flags1 bit, if thread has finished
+#define ThreadStackless 0x08 //!< Flags1 bit, if yielder only saves its frame's registers between calls
 
 /** Mark all in-use thread values for garbage collection 
  * Increments how much allocated memory the thread uses. */
@@ -76,11 +76,12 @@ typedef struct ThreadInfo {
 		mem_markobj(th, *stkp); \
 	} mem_markobj(th, (t)->yieldTo);}
 
-/** Free all of an array's allocated memory */
+/** Free all of a thread's allocated memory (or park a yielder in the VM's pool for reuse) */
 #define thrFree(th, t) \
 	{assert(th!=t && "Never sweep thread we are using"); \
-	thrFreeStacks(t); \
-	mem_free(th, (t));}
+	if (!thrPool(th, t)) { \
+		thrFreeStacks(t); \
+		mem_free(th, (t));}}
 
 /** Turn the thread value into a pointer */
 #define th(th) ((ThreadInfo*) th)
@@ -99,20 +100,43 @@ void stkRealloc(Value th, int newsize);
 
 /** Initialize a thread */
 void thrInit(ThreadInfo* thr, VmInfo* vm, Value method, AuintIdx stksz, char flags);
+/** Empty a thread's stacks, leaving only the entry call frame for its method */
+void thrResetCI(ThreadInfo* thr, Value method);
 
 /** Free everything allocated for thread */
 void thrFreeStacks(Value th);
 
-/** Internal routine to allocate and append a new CallInfo structure to end of call stack */
+/** Keep a dead yielder (and its stacks) in the VM's pool for reuse, rather than freeing it.
+ * Returns false if the thread must be freed instead. */
+bool thrPool(Value th, ThreadInfo *t);
+
+/** Free all yielder threads held in the VM's pool */
+void thrFreePool(Value th);
+
+/** Internal routine to grow the call stack, returning the new current frame just above the old one */
 CallInfo *thrGrowCI(Value th);
 
+/** Push a new call frame (growing the call stack if full) and make it the current one */
+#define thrPushCI(t) (th(t)->curmethod < th(t)->calls_last? ++th(t)->curmethod : thrGrowCI(t))
+
+/** The call frame for the C-method that started the thread */
+#define thrEntryCI(t) (th(t)->calls)
+
 /** Retrieve a value from global namespace */
 Value gloGet(Value th, Value var);
 /** Add or change a global variable */
 void gloSet(Value th, Value var, Value val);
+/** Return the cell bound to a global variable (creating it if needed) */
+Value gloCell(Value th, Value var);
+/** Refresh a global variable's bound cell (if it has one) with its new value */
+void gloCellSet(Value th, Value var, Value val);
 
 /** Create a new Thread with a starter stack. */
 Value newThread(Value th, Value *dest, Value method, AuintIdx stksz, char flags);
+/** Create a new yielder for a byte-code method, recycling a pooled one when possible */
+Value newYielder(Value th, Value *dest, Value method);
+/** Create a new stackless yielder, which resumes its method's frame on the calling thread */
+Value newStacklessYielder(Value th, Value *dest, Value method);
 /** Push and return a new CompInfo value, compiler state for an Acorn method */
 Value pushCompiler(Value th, Value src, Value url);
 
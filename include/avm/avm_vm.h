@@ -35,6 +35,7 @@ extern "C" {
 		uint64_t pcgrng_inc;		//!< PCG random-number generator inc value
 
 		Value global;				//!< VM's "built in" Global hash table
+		Value globalcells;			//!< Cells bound to global variables, indexed by name (see gloCell)
 
 		Value main_thread;			//!< VM's main thread
 		struct ThreadInfo main_thr; //!< State space for main thread
@@ -44,12 +45,19 @@ extern "C" {
 		Value literals;				//!< array of all built-in symbol and type literals 
 		Value stdidx;				//!< Table to convert std symbol to index
 		Value *stdsym;				//!< c-array to convert index to std symbol
+		uint64_t typeepoch;			//!< Changes whenever inheritance or a searched type's properties change (invalidating property caches). 64-bit, so it never wraps back to a stale cache's epoch
+		struct Shape *rootshape;	//!< Empty shape, the root of all shapes (see avm_table.h)
+		Auint nbrshapes;			//!< Number of shapes created
+		Auint jitthreshold;			//!< How hot a bytecode method must be before it is translated to native code (0=never)
+		char fastnumops;			//!< true while Integer/Float operator methods are unchanged (allows inline arithmetic)
 
 		// Garbage Collection state
 		MemInfo *objlist;			//!< linked list of all collectable objects
 		MemInfo **sweepgc;			//!< current position of sweep in list 'objlist'
 		MemInfoGray *gray;			//!< list of gray objects
 		MemInfo *threads;			//!< list of all threads
+		MemInfo *yielderpool;		//!< dead yielder threads kept (with their stacks) for reuse
+		int yielderpoolsz;			//!< number of threads in yielderpool
 
 		Auint sweepsymgc;			//!< position of sweep in symbol table
 
@@ -60,6 +68,7 @@ extern "C" {
 		int gcnbrold;				//!< number of old objects created since last gen GC cycle
 		int gcnewtrigger;			//!< Start a new GC cycle after this exceeds gcnbrnew
 		int gcoldtrigger;			//!< Make next GC cycle full if this exceeds gcnbrold
+		int gcnbrlive;				//!< number of objects that survived the last full GC cycle's sweep
 		int gcstepunits;			//!< How many work units left to consume in GC step
 
 		// Statistics gathering for GC
@@ -69,6 +78,15 @@ extern "C" {
 
 		Auint totalbytes;			//!< number of bytes currently allocated
 
+#ifndef AVM_NONURSERY
+		// Nursery of small, mostly short-lived memory blocks (see avm_memory.cpp)
+		char *nursery;				//!< Arena of AVM_NURSERYSIZE bytes (NULL if not allocated)
+		char *nurserytop;			//!< Where the arena's next never-used memory block goes
+		char *nurseryend;			//!< End of the arena
+		Auint nurserylive;			//!< Number of memory blocks from the arena in use
+		void *nurseryfree[AVM_NURSERYMAXSZ/AVM_NURSERYALIGN];	//!< Lists of freed memory blocks, by size
+#endif
+
 		char gcmode;				//!< Collection mode: Normal, Emergency, Gen
 		char gcnextmode;			//!< Collection mode for next cycle
 		char gcstate;				//!< state of garbage collector
@@ -83,6 +101,7 @@ extern "C" {
 	#define vmMark(th, v) \
 		{mem_markobj(th, (v)->main_thread); \
 		mem_markobj(th, (v)->global); \
+		mem_markobj(th, (v)->globalcells); \
 		mem_markobj(th, (v)->literals); \
 		mem_markobj(th, (v)->stdidx);}
 
@@ -217,6 +236,8 @@ extern "C" {
 		TypeClom,	//!< Closure mixin
 		TypeIndexc,	//!< Index class
 		TypeIndexm,	//!< Index mixin
+		TypeTextIndexc,	//!< TextIndex class
+		TypeTextIndexm,	//!< TextIndex mixin
 		TypeResc,	//!< Index class
 		TypeResm,	//!< Index mixin
 		TypeAll,	//!< All
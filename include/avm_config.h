@@ -17,12 +17,16 @@
 
 /** Symbol table minimum size - starting size, in number of entries */
 #define AVM_SYMTBLMINSIZE	128
+/** Number of old symbol table slots moved to the new array each time a symbol is added */
+#define AVM_SYMREHASHSTEP	8
 
 // Garbage Collection tuning
 /** How many new objects will trigger start of a GC cycle */
 #define GCNEWTRIGGER 200
-/** How many objects converted from new to old will trigger a full collection */
+/** How many objects converted from new to old will trigger a full collection (at least) */
 #define GCOLDTRIGGER 1000
+/** Percent growth in old objects, over those that survived the last full collection, that triggers another */
+#define GCOLDGROWTH 100
 /** How much work to perform (at most) per GC step */
 #define GCMAXSTEPCOST 500
 /** Unit cost for marking an object's values */
@@ -32,6 +36,14 @@
 /** Unit cost for freeing a dead object during a GC sweep */
 #define GCSWEEPDEADCOST 12
 
+/** Small memory blocks allocated while the garbage collector runs are bump-allocated from a nursery
+ * arena of this many bytes. Define AVM_NONURSERY to malloc every memory block. */
+#define AVM_NURSERYSIZE (1024*1024)
+/** Largest memory block allocated from the nursery, in bytes */
+#define AVM_NURSERYMAXSZ 256
+/** Nursery memory blocks are rounded up to a multiple of this size (a power of 2) */
+#define AVM_NURSERYALIGN 16
+
 /** Minimum expected room on data stack for c-methods */
 #define STACK_MINSIZE 20
 /** Extra just-in-case room on stack, to provide safety in case a method goes too far */
@@ -42,9 +54,43 @@
 #define STACK_MAXSIZE 16384
 /** Maximum size of stack under error recovery */
 #define STACK_ERRORSIZE (STACK_MAXSIZE+200)
+/** Initial number of call frames for a new thread (doubled as needed) */
+#define CALLSTACK_NEWSIZE 8
+/** Maximum number of finished yielder threads the VM keeps for reuse */
+#define YIELDER_POOLSIZE 32
+
+/** Number of receiver types a call site's property cache remembers (beyond this it stops caching) */
+#define AVM_PROPCACHESIZE 4
+
+/** Number of property lookups a Type's cache remembers, by the property symbol's hash (a power of 2) */
+#define AVM_TYPECACHESIZE 32
+
+/** Most Symbol keys a Type or object keeps in a shared shape before switching to a hashed index */
+#define AVM_SHAPEMAXKEYS 16
+/** Most shapes the VM creates (beyond this, new key sequences use a hashed index) */
+#define AVM_SHAPEMAX 4096
+
+/** Bytecode interpreter uses direct-threaded dispatch (computed goto) when the compiler
+ * supports it (GCC/Clang). Define AVM_NOCOMPUTEDGOTO to force the portable switch dispatch. */
+#if defined(__GNUC__) && !defined(AVM_NOCOMPUTEDGOTO)
+#define AVM_COMPUTEDGOTO
+#endif
+
+/** Hot bytecode methods are translated to native code on x86-64 Linux.
+ * Define AVM_NOJIT to leave all bytecode to the interpreter. */
+#if defined(__x86_64__) && defined(__linux__) && !defined(AVM_NOJIT)
+#define AVM_JIT
+#endif
+
+/** Hashed table indexes use the Swiss-table engine on x86-64 (open addressing, probing 16 control
+ * bytes at once with SSE2). Define AVM_NOSWISSTABLE to use the chained scatter table instead. */
+#if (defined(__x86_64__) || defined(_M_X64)) && !defined(AVM_NOSWISSTABLE)
+#define AVM_SWISSTABLE
+#endif
 
-/** 2^AVM_STRHASHLIMIT is roughly max number of bytes used to compute string hash */
-#define AVM_STRHASHLIMIT	5
+/** Calls plus loop iterations that make a bytecode method hot enough to translate (0 turns the JIT off).
+ * It can be changed at run time using Vm.Jit */
+#define AVM_JITTHRESHOLD 1000
 
 /** Only define this if you are testing garbage collection. It forces full garbage collect before asking for more memory */
 // #define AVM_GCHARDMEMTEST
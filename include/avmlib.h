@@ -22,6 +22,7 @@
 #include "avm/avm_array.h"
 #include "avm/avm_table.h"
 #include "avm/avm_method.h"
+#include "avm/avm_jit.h"
 #include "avm/avm_thread.h"
 #include "acorn/acn_main.h"
 #include "avm/avm_vm.h" // Should be last
@@ -22,6 +22,7 @@ void newBMethod(Value th, Value *dest) {
 	methodNParms(meth) = 1; // 'self'
 
 	meth->code = NULL;
+	meth->runcode = NULL;
 	meth->maxstacksize = 20;
 	meth->avail = 0;
 	meth->size = 0;
@@ -30,6 +31,10 @@ void newBMethod(Value th, Value *dest) {
 	meth->nbrlits = 0;
 	meth->nbrexterns = 0;
 	meth->nbrlocals = 0;
+	meth->propcache = NULL;
+	meth->nbrpropcache = 0;
+	meth->jit = NULL;
+	meth->jithits = 0;
 }
 
 /* Put new instruction in code array */
@@ -42,6 +47,11 @@ void genPutInstr(CompInfo *comp, AuintIdx loc, Instruction i) {
 void genAddInstr(CompInfo *comp, Instruction i) {
 	mem_growvector(comp->th, comp->method->code, comp->method->size, comp->method->avail, Instruction, INT_MAX);
 	comp->method->code[comp->method->size++] = i;
+
+	// Property lookups are followed by the index of their call site's property cache
+	BCOp op = bc_op(i);
+	if (op==OpGetCall || op==OpGetProp || op==OpGetActProp)
+		genAddInstr(comp, BCINS_Ax(OpExtraArg, comp->method->nbrpropcache++));
 }
 
 /* Add a literal and return its index */
@@ -63,6 +73,11 @@ int genAddLit(CompInfo *comp, Value val) {
 	return f->nbrlits++;
 }
 
+/* Add a global variable's bound cell as a literal (see gloCell) and return its index */
+int genAddGlobal(CompInfo *comp, Value var) {
+	return genAddLit(comp, gloCell(comp->th, var));
+}
+
 /* Indicate the method has a variable number of parameters */
 void genVarParms(CompInfo *comp) {
 	methodFlags(comp->method) = METHOD_FLG_VARPARM;
@@ -78,7 +93,7 @@ Value genLocalVars(CompInfo *comp, Value blockvarseg,int nexpected) {
 			comp->locvarseg = blockvarseg;
 			arrSet(th, comp->locvarseg, 1, anInt(comp->nextreg));
 			if (nbrvars-nexpected>0)
-				genAddInstr(comp, BCINS_ABC(OpLoadNulls, comp->nextreg+nexpected, nbrvars-nexpected, 0));
+				genAddInstr(comp, BCINS_ABC(OpLoadNulls, comp->nextreg+nexpected, nbrvars-nexpected-1, 0));
 			comp->nextreg += nbrvars;
 			if (comp->method->maxstacksize < comp->nextreg+nbrvars)
 				comp->method->maxstacksize = comp->nextreg+nbrvars;
@@ -89,7 +104,7 @@ Value genLocalVars(CompInfo *comp, Value blockvarseg,int nexpected) {
 
 /* Raise method's max stack size if register is above it */
 void genMaxStack(CompInfo *comp, AuintIdx reg) {
-	if (comp->method->maxstacksize < reg)
+	if (comp->method->maxstacksize <= reg)
 		comp->method->maxstacksize = reg+1;
 }
 
@@ -249,6 +264,13 @@ void genJumpExp(CompInfo *comp, Value astseg, int *failjump, int *passjump, bool
 		}
 	}
 
+	// A literal's outcome is already known: jump always or never
+	else if (isArr(astseg) && condop == vmlit(SymLit)) {
+		if (isFalse(astGet(th, astseg, 1)) == revjump)
+			genFwdJump(comp, OpJump, 0, lastjump? failjump : passjump);
+		return;
+	}
+
 	// Otherwise, an expression to be interpreted as false/null or true (anything else)
 	// (which includes explicit use of <==>)
 	else {
@@ -258,11 +280,12 @@ void genJumpExp(CompInfo *comp, Value astseg, int *failjump, int *passjump, bool
 		return;
 	}
 
-	// Generate code for rocket-based comparisons
-	genAddInstr(comp, BCINS_ABx(OpLoadLit, genNextReg(comp), genAddLit(comp, vmlit(SymRocket))));
+	// Generate code for rocket-based comparisons. Register for result is also where '<=>' goes
+	// if it has to be called. The jump must immediately follow OpRocket, which may perform it.
+	genNextReg(comp);
 	genExp(comp, astGet(th, astseg, 1));
 	genExp(comp, astGet(th, astseg, 2));
-	genAddInstr(comp, BCINS_ABC(OpGetCall, svnextreg, comp->nextreg - svnextreg-1, 1));
+	genAddInstr(comp, BCINS_ABC(OpRocket, svnextreg, svnextreg+1, svnextreg+2));
 	genFwdJump(comp, jumpop, svnextreg,  lastjump? failjump : passjump);
 	comp->nextreg = svnextreg;
 }
@@ -284,6 +307,7 @@ void genReturn(CompInfo *comp, Value aststmt, int op, int expected) {
 			genDoProp(comp, retexp, OpTailCall, aNull, 1);
 		// For solo splat, load parameter varargs and return them
 		else if (retexp == vmlit(SymSplat)) {
+			genMaxStack(comp, svnextreg);
 			genAddInstr(comp, BCINS_ABC(OpLoadVararg, svnextreg, 0xFF, 0));
 			genAddInstr(comp, BCINS_ABC(op, svnextreg, 0xFF, expected));
 		}
@@ -326,6 +350,48 @@ char genIsProp(Value th, Value op, int setflag) {
 	return 0;
 }
 
+/** Generate arithmetic opcode for binary +, -, * or / call (see OpAdd). 
+	Return false (generating nothing) if the call is something else */
+bool genArith(CompInfo *comp, Value astseg) {
+	Value th = comp->th;
+
+	// Must be a call of an arithmetic operator symbol with exactly one parameter
+	Value prop = astGet(th, astseg, 2);
+	if (getSize(astseg)!=4 || !isArr(prop) || astGet(th, prop, 0)!=vmlit(SymLit))
+		return false;
+	int opcode;
+	Value opsym = astGet(th, prop, 1);
+	if (opsym==vmlit(SymPlus)) opcode = OpAdd;
+	else if (opsym==vmlit(SymMinus)) opcode = OpSub;
+	else if (opsym==vmlit(SymMult)) opcode = OpMul;
+	else if (opsym==vmlit(SymDiv)) opcode = OpDiv;
+	else return false;
+	Value self = astGet(th, astseg, 1);
+	Value parm = astGet(th, astseg, 3);
+	if (parm==vmlit(SymSplat) || (isArr(parm) && astGet(th, parm, 0)==vmlit(SymYield)))
+		return false;
+
+	// Result goes in next register. Operator's method, self and parm go there if it has to be called.
+	unsigned int svreg = genNextReg(comp);
+	genMaxStack(comp, svreg+2);
+
+	// Use local variable registers in place, unless parm's evaluation might change self's
+	int parmreg = genExpReg(comp, parm);
+	int selfreg = genExpReg(comp, self);
+	if (selfreg<0 || (parmreg<0 && !(isArr(parm) && astGet(th, parm, 0)==vmlit(SymLit)))) {
+		selfreg = comp->nextreg;
+		genExp(comp, self);
+		comp->nextreg = selfreg+1;
+	}
+	if (parmreg<0) {
+		parmreg = comp->nextreg;
+		genExp(comp, parm);
+	}
+	genAddInstr(comp, BCINS_ABC(opcode, svreg, selfreg, parmreg));
+	comp->nextreg = svreg+1;
+	return true;
+}
+
 /** Generate code for some kind of property/method call.
     rval is aNull for 'get' mode and either a register integer or ast segment for 'set' mode. 
 	nexpected specifies how many return values expected from called method */
@@ -426,7 +492,7 @@ void genAssign(CompInfo *comp, Value lval, Value rval) {
 			int nrneed = varrvals? 0 : nlvals - (comp->nextreg - rvalreg);
 			// Ensure we fill up right values with nulls to as high as left values
 			if (nrneed > 0) {
-				genAddInstr(comp, BCINS_ABC(OpLoadNulls, comp->nextreg, nrneed, 0));
+				genAddInstr(comp, BCINS_ABC(OpLoadNulls, comp->nextreg, nrneed-1, 0));
 				comp->nextreg += nrneed;
 				// Keep track of high-water mark for later stack allocation purposes
 				if (comp->method->maxstacksize < comp->nextreg+nrneed)
@@ -444,10 +510,10 @@ void genAssign(CompInfo *comp, Value lval, Value rval) {
 			if (localreg != -1)
 				genAddInstr(comp, BCINS_ABC(OpLoadReg, localreg, rvalreg, 0));
 			else if ((localreg = findClosureVar(comp, symnm))!=-1)
-				genAddInstr(comp, BCINS_ABC(OpSetClosure, localreg, rvalreg, 0));
+				genAddInstr(comp, BCINS_ABC(OpSetClosure, rvalreg, localreg, 0));
 		// Load into a global variable
 		} else if (vmlit(SymGlobal) == lvalop)
-			genAddInstr(comp, BCINS_ABx(OpSetGlobal, rvalreg, genAddLit(comp, astGet(th, lval, 1))));
+			genAddInstr(comp, BCINS_ABx(OpSetGlobal, rvalreg, genAddGlobal(comp, astGet(th, lval, 1))));
 	}
 	// We do not consume values, so we don't restore comp->nextreg
 }
@@ -485,7 +551,7 @@ void genOptAssign(CompInfo *comp, Value lval, Value rval) {
 					// We did local already - this must be a load from a closure variable
 					genAddInstr(comp, BCINS_ABC(OpGetClosure, localreg, findClosureVar(comp, astGet(th, rval, 1)), 0));
 				} else if (vmlit(SymGlobal) == rvalop) {
-					genAddInstr(comp, BCINS_ABx(OpGetGlobal, localreg, genAddLit(comp, astGet(th, rval, 1))));
+					genAddInstr(comp, BCINS_ABx(OpGetGlobal, localreg, genAddGlobal(comp, astGet(th, rval, 1))));
 				} else {
 					fromreg = comp->nextreg; // Save where we put rvals
 					genExp(comp, rval);
@@ -496,15 +562,15 @@ void genOptAssign(CompInfo *comp, Value lval, Value rval) {
 		else if ((localreg = findClosureVar(comp, symnm))!=-1) {
 			fromreg = comp->nextreg; // Save where we put rvals
 			genExp(comp, rval);
-			genAddInstr(comp, BCINS_ABC(OpSetClosure, localreg, fromreg, 0));
+			genAddInstr(comp, BCINS_ABC(OpSetClosure, fromreg, localreg, 0));
 		}
 	} else if (vmlit(SymGlobal) == lvalop) {
 		if (fromreg != -1)
-			genAddInstr(comp, BCINS_ABx(OpSetGlobal, fromreg, genAddLit(comp, astGet(th, lval, 1))));
+			genAddInstr(comp, BCINS_ABx(OpSetGlobal, fromreg, genAddGlobal(comp, astGet(th, lval, 1))));
 		else {
 			fromreg = comp->nextreg; // Save where we put rvals
 			genExp(comp, rval);
-			genAddInstr(comp, BCINS_ABx(OpSetGlobal, fromreg, genAddLit(comp, astGet(th, lval, 1))));
+			genAddInstr(comp, BCINS_ABx(OpSetGlobal, fromreg, genAddGlobal(comp, astGet(th, lval, 1))));
 		}
 	} else 
 		genAssign(comp, lval, rval);
@@ -524,6 +590,45 @@ bool hasNoBool(Value th, Value astseg) {
 	return true;
 }
 
+/** Generate a new closure from its ('callprop', Closure, New, getmethod, setmethod, closure vars...) segment.
+	A closure with no variables and literal methods captures nothing, so it is built once here
+	and shared as a literal. Otherwise its methods and variables are loaded into consecutive
+	registers for NewClosure, as every closure variable needs its own (mutable) slot. */
+void genClosure(CompInfo *comp, Value newcloseg) {
+	Value th = comp->th;
+	AuintIdx nvals = arr_size(newcloseg) - 3;
+
+	// Does it capture anything?
+	bool captures = nvals > 2;
+	for (AuintIdx i = 3; i < arr_size(newcloseg); i++) {
+		Value valseg = astGet(th, newcloseg, i);
+		Value op = isArr(valseg)? astGet(th, valseg, 0) : aNull;
+		if (op!=vmlit(SymLit) && op!=vmlit(SymExt))
+			captures = true;
+	}
+
+	if (!captures) {
+		for (AuintIdx i = 3; i < arr_size(newcloseg); i++) {
+			Value valseg = astGet(th, newcloseg, i);
+			Value val = astGet(th, valseg, 1);
+			pushValue(th, astGet(th, valseg, 0)==vmlit(SymExt)? comp->method->lits[toAint(val)] : val);
+		}
+		pushClosure(th, nvals);
+		genAddInstr(comp, BCINS_ABx(OpLoadLit, genNextReg(comp), genAddLit(comp, getFromTop(th, 0))));
+		popValue(th);
+		return;
+	}
+
+	unsigned int cloreg = comp->nextreg;
+	for (AuintIdx i = 3; i < arr_size(newcloseg); i++) {
+		AuintIdx valreg = comp->nextreg;
+		genExp(comp, astGet(th, newcloseg, i));
+		comp->nextreg = valreg+1;
+	}
+	genAddInstr(comp, BCINS_ABC(OpNewClosure, cloreg, nvals, 0));
+	comp->nextreg = cloreg+1;
+}
+
 /** Generate the appropriate code for something that places one or more values on the stack
 	beginning at comp->nextreg (which should be saved before calling this). The last value is at comp->nextreg-1 */
 void genExp(CompInfo *comp, Value astseg) {
@@ -544,7 +649,9 @@ void genExp(CompInfo *comp, Value astseg) {
 	} else if (isArr(astseg)) {
 		Value op = astGet(th, astseg, 0);
 		char opcode = genIsProp(th, op, false);
-		if (opcode) // Property or method use
+		if (opcode==OpGetCall && genArith(comp, astseg))
+			; // Arithmetic operator generated
+		else if (opcode) // Property or method use
 			genDoProp(comp, astseg, opcode, aNull, 1);
 		else if (vmlit(SymComma) == op) {
 			int nvals = arr_size(astseg)-1;
@@ -570,7 +677,7 @@ void genExp(CompInfo *comp, Value astseg) {
 			else if ((idx = findClosureVar(comp, symnm))!=-1)
 				genAddInstr(comp, BCINS_ABC(OpGetClosure, genNextReg(comp), idx, 0));
 		} else if (vmlit(SymGlobal) == op) {
-			genAddInstr(comp, BCINS_ABx(OpGetGlobal, genNextReg(comp), genAddLit(comp, astGet(th, astseg, 1))));
+			genAddInstr(comp, BCINS_ABx(OpGetGlobal, genNextReg(comp), genAddGlobal(comp, astGet(th, astseg, 1))));
 		} else if (vmlit(SymAssgn) == op) {
 			genAssign(comp, astGet(th, astseg, 1), astGet(th, astseg, 2));
 		} else if (vmlit(SymYield) == op) {
@@ -582,7 +689,7 @@ void genExp(CompInfo *comp, Value astseg) {
 			if (arr_size(newcloseg)==5 && isArr(setmethseg) && astGet(th, setmethseg, 1)==vmlit(SymNull))
 				genExp(comp, astGet(th, newcloseg, 3));
 			else
-				genExp(comp, newcloseg);
+				genClosure(comp, newcloseg);
 		} else if (vmlit(SymOrAssgn) == op) {
 			// Assumes that lvar is a local variable
 			assert(astGet(th, astGet(th, astseg, 1), 0)==vmlit(SymLocal));
@@ -719,6 +826,51 @@ void genMatchWith(CompInfo *comp, Value pattern, unsigned int matchreg, int nexp
 	genAddInstr(comp, BCINS_ABC(OpGetCall, matchreg+2, 2, nexpected==0? 1 : nexpected));
 }
 
+/** Is pattern a literal that Switch can look up: an Integer, Symbol, null, true or false? */
+bool genIsSwitchLit(Value th, Value pattern) {
+	if (!isArr(pattern) || astGet(th, pattern, 0)!=vmlit(SymLit))
+		return false;
+	Value lit = astGet(th, pattern, 1);
+	return isInt(lit) || isSym(lit) || lit==aNull || lit==aTrue || lit==aFalse;
+}
+
+/** Can a match block use Switch to go straight to the 'with' block for the value?
+ * Only if it matches using '~~' on literals Switch can look up, without 'into' variables. */
+bool genCanSwitch(Value th, Value astseg) {
+	if (astGet(th, astseg, 2)!=vmlit(SymMatchOp))
+		return false;
+	AuintIdx npatterns = 0;
+	for (AuintIdx mtchindx = 3; mtchindx < getSize(astseg); mtchindx += 4) {
+		Value condast = astGet(th, astseg, mtchindx);
+		if (condast==vmlit(SymElse))
+			continue;
+		if (toAint(astGet(th, astseg, mtchindx+2))!=0)
+			return false;
+		if (isArr(condast) && arrGet(th, condast, 0)==vmlit(SymComma)) {
+			for (AuintIdx i=1; i<arr_size(condast); i++, npatterns++)
+				if (!genIsSwitchLit(th, arrGet(th, condast, i)))
+					return false;
+		}
+		else if (genIsSwitchLit(th, condast))
+			npatterns++;
+		else
+			return false;
+	}
+	return npatterns>=2;
+}
+
+/** Have Switch's Index send each of a 'with' clause's literal patterns to the next instruction.
+ * An earlier clause's pattern wins. null is left to the patterns' '~~' calls. */
+void genSwitchCase(CompInfo *comp, Value switchtbl, Value condast) {
+	Value th = comp->th;
+	bool multi = isArr(condast) && arrGet(th, condast, 0)==vmlit(SymComma);
+	for (AuintIdx i = multi? 1 : 0; i < (multi? arr_size(condast) : 1); i++) {
+		Value lit = astGet(th, multi? arrGet(th, condast, i) : condast, 1);
+		if (lit!=aNull && !tblGetp(switchtbl, lit))
+			tblSet(th, switchtbl, lit, anInt(comp->method->size));
+	}
+}
+
 /** Generate match block */
 void genMatch(CompInfo *comp, Value astseg) {
 	Value th = comp->th;
@@ -732,6 +884,16 @@ void genMatch(CompInfo *comp, Value astseg) {
 	else
 		genExp(comp, mtchmethexp);
 
+	// A match on literals first looks up the value's 'with' block with Switch
+	Value switchtbl = aNull;
+	int jumpElseIp = BCNO_JMP;	// Switch's jump to 'else' block (or end), if not found
+	if (genCanSwitch(th, astseg)) {
+		switchtbl = pushTbl(th, vmlit(TypeIndexm), 8);
+		genFwdJump(comp, OpSwitch, matchreg, &jumpElseIp);
+		genAddInstr(comp, BCINS_Ax(OpExtraArg, genAddLit(comp, switchtbl)));
+		popValue(th);
+	}
+
 	// Process all 'with' blocks in astseg
 	AuintIdx mtchindx = 3;		// Index into astseg for each 'with' block
 	while (mtchindx < getSize(astseg)) {
@@ -755,6 +917,14 @@ void genMatch(CompInfo *comp, Value astseg) {
 			genMatchWith(comp, condast, matchreg, nexpected);
 			genFwdJump(comp, OpJFalse, matchreg+2, &jumpNextIp);
 		}
+		if (switchtbl!=aNull) {
+			if (condast==vmlit(SymElse)) {
+				genSetJumpList(comp, jumpElseIp, comp->method->size);
+				jumpElseIp = BCNO_JMP;
+			}
+			else
+				genSwitchCase(comp, switchtbl, condast);
+		}
 		comp->nextreg = matchreg+2;
 		Value svLocalVars = genLocalVars(comp, astGet(th, astseg, mtchindx+1), nexpected);
 		genStmts(comp, astGet(th, astseg, mtchindx+3)); // Generate block
@@ -768,6 +938,7 @@ void genMatch(CompInfo *comp, Value astseg) {
 		mtchindx += 4;
 	}
 	genSetJumpList(comp, jumpEndIp, comp->method->size); // Fix jumps to end of 'match'
+	genSetJumpList(comp, jumpElseIp, comp->method->size);
 	comp->nextreg = matchreg;
 }
 
@@ -798,23 +969,92 @@ void genWhile(CompInfo *comp, Value astseg) {
 	comp->locvarseg = svLocalVars;
 }
 
+/** whileBegIp of a for block, whose 'continue' jumps forward (see whileContIp) */
+#define GENFWDCONT -2
+
+/** Is iter a literal Range: ('CallProp', ('Global','Range'), ('Lit','New'), from, to, step)? */
+bool genIsRangeLit(Value th, Value iter) {
+	if (!isArr(iter) || arr_size(iter)<5 || astGet(th, iter, 0)!=vmlit(SymCallProp))
+		return false;
+	Value type = astGet(th, iter, 1);
+	Value meth = astGet(th, iter, 2);
+	return isArr(type) && astGet(th, type, 0)==vmlit(SymGlobal) && astGet(th, type, 1)==vmlit(SymRange)
+		&& isArr(meth) && astGet(th, meth, 0)==vmlit(SymLit) && astGet(th, meth, 1)==vmlit(SymNew);
+}
+
+/** Generate each block over a literal Range, whose values ForPrep and ForLoop step through */
+void genFor(CompInfo *comp, Value astseg) {
+	Value th = comp->th;
+	unsigned int savereg = comp->nextreg;
+	Value iter = astGet(th, astseg, 3);
+
+	// Load from, to and step (null for its default) after the register for the kind of iteration
+	genNextReg(comp);
+	genExp(comp, astGet(th, iter, 3));
+	genExp(comp, astGet(th, iter, 4));
+	if (arr_size(iter)>5)
+		genExp(comp, astGet(th, iter, 5));
+	else
+		genAddInstr(comp, BCINS_ABC(OpLoadPrim, genNextReg(comp), 0, 0));
+
+	// Allocate block's local variables, which ForPrep then loads with the first values
+	Value svLocalVars = genLocalVars(comp, astGet(th, astseg, 1), 0);
+	int prepIp = BCNO_JMP;
+	genFwdJump(comp, OpForPrep, savereg, &prepIp);
+
+	// Generate block, then ForLoop (where 'continue' goes) to jump back to its start
+	int svJumpBegIp = comp->whileBegIp;
+	int svJumpEndIp = comp->whileEndIp;
+	int svJumpContIp = comp->whileContIp;
+	comp->whileBegIp = GENFWDCONT;
+	comp->whileEndIp = BCNO_JMP;
+	comp->whileContIp = BCNO_JMP;
+	int begIp = comp->method->size;
+	genStmts(comp, astGet(th, astseg, 4));
+	genSetJumpList(comp, prepIp, comp->method->size);
+	genSetJumpList(comp, comp->whileContIp, comp->method->size);
+	genAddInstr(comp, BCINS_AJ(OpForLoop, savereg, begIp - comp->method->size-1));
+	genSetJumpList(comp, comp->whileEndIp, comp->method->size); // Fix jump to end of 'for' block
+
+	// Restore block's saved values
+	comp->nextreg = savereg;
+	comp->whileBegIp = svJumpBegIp;
+	comp->whileEndIp = svJumpEndIp;
+	comp->whileContIp = svJumpContIp;
+	comp->locvarseg = svLocalVars;
+}
+
 /** Generate each block */
 void genEach(CompInfo *comp, Value astseg) {
 	Value th = comp->th;
 	unsigned int savereg = comp->nextreg;
 
-	// Prepare iterator for 'each' block outside of main loop (loaded in savereg)
+	// Each over a literal Range (with just key and value variables) is done as a for loop
+	if (toAint(astGet(th, astseg, 2))==2 && genIsRangeLit(th, astGet(th, astseg, 3))) {
+		genFor(comp, astseg);
+		return;
+	}
+
+	// Prepare iterator for 'each' block outside of main loop (loaded in savereg).
+	// Except for splat, three registers hold native iteration state ahead of the iterator.
 	Value iter = astGet(th, astseg, 3);
-	if (iter == vmlit(SymSplat))
+	unsigned int keyreg;
+	if (iter == vmlit(SymSplat)) {
 		genAddInstr(comp, BCINS_ABx(OpLoadLit, genNextReg(comp), genAddLit(comp, anInt(0))));
+		keyreg = savereg+1;
+	}
 	else {
+		genNextReg(comp); genNextReg(comp); genNextReg(comp);
 		int fromreg = genExpReg(comp, iter);
 		if (fromreg==-1) {
 			genExp(comp, iter);
-			genAddInstr(comp, BCINS_ABC(OpEachPrep, savereg, savereg, 0));
+			genAddInstr(comp, BCINS_ABC(OpEachPrep, savereg, savereg+3, 0));
 		}
-		else
-			genAddInstr(comp, BCINS_ABC(OpEachPrep, genNextReg(comp), fromreg, 0));
+		else {
+			genNextReg(comp);
+			genAddInstr(comp, BCINS_ABC(OpEachPrep, savereg, fromreg, 0));
+		}
+		keyreg = savereg+4;
 	}
 
 	// Allocate block's local variables
@@ -826,7 +1066,7 @@ void genEach(CompInfo *comp, Value astseg) {
 	comp->whileBegIp = comp->method->size;
 	comp->whileEndIp = BCNO_JMP;
 	genAddInstr(comp, BCINS_ABC(iter == vmlit(SymSplat)? OpEachSplat : OpEachCall, savereg, 0, toAint(astGet(th, astseg,2))));
-	genFwdJump(comp, OpJFalse, savereg+1, &comp->whileEndIp);
+	genFwdJump(comp, OpJFalse, keyreg, &comp->whileEndIp);
 
 	// Generate block and jump to beginning. Fix conditional jump to after 'while' block
 	genStmts(comp, astGet(th, astseg, 4)); // Generate block
@@ -896,6 +1136,8 @@ void genStmt(CompInfo *comp, Value aststmt) {
 	else if (op==vmlit(SymDo)) genDo(comp, aststmt);
 	else if (op==vmlit(SymBreak) && comp->whileBegIp!=-1)
 		genFwdJump(comp, OpJump, 0, &comp->whileEndIp);
+	else if (op==vmlit(SymContinue) && comp->whileBegIp==GENFWDCONT)
+		genFwdJump(comp, OpJump, 0, &comp->whileContIp);
 	else if (op==vmlit(SymContinue) && comp->whileBegIp!=-1)
 		genAddInstr(comp, BCINS_AJ(OpJump, 0, comp->whileBegIp - comp->method->size-1));
 	else if (op==vmlit(SymReturn))
@@ -965,6 +1207,275 @@ void genFixReturns(CompInfo *comp, Value aststmts) {
 		astInsSeg(th, aststmts, vmlit(SymReturn), 2);
 }
 
+/** How an instruction uses a register (see genRegUse) */
+enum GenRegUses {
+	GenRegNone,		//!< Not used (or perhaps changed, but not certainly)
+	GenRegRead,		//!< Its value is (or may be) used
+	GenRegSet		//!< Overwritten without its value being used
+};
+
+/** How does instruction i use register reg? Uncertain cases count as a read. */
+int genRegUse(Instruction i, BCReg reg) {
+	BCReg a = bc_a(i), b = bc_b(i), c = bc_c(i);
+	switch (bc_op(i)) {
+	case OpLoadReg:
+		return reg==b? GenRegRead : reg==a? GenRegSet : GenRegNone;
+	case OpLoadRegs:
+		return (reg>=b && reg<b+c)? GenRegRead : (reg>=a && reg<a+c)? GenRegSet : GenRegNone;
+	case OpLoadLit: case OpLoadLitx: case OpLoadPrim: case OpLoadContext: case OpGetGlobal:
+	case OpGetClosure:
+		return reg==a? GenRegSet : GenRegNone;
+	case OpLoadNulls:
+		return (reg>=a && reg<=a+b)? GenRegSet : GenRegNone;
+	case OpLoadVararg:
+		return (reg>=a && (b==BCVARRET || reg<a+b))? GenRegSet : GenRegNone;
+	case OpExtraArg: case OpJump:
+		return GenRegNone;
+	case OpSetGlobal: case OpSetClosure: case OpJNull: case OpJNNull: case OpJTrue: case OpJFalse:
+	case OpJEq: case OpJNe: case OpJLt: case OpJLe: case OpJGt: case OpJGe:
+	case OpJEqN: case OpJNeN: case OpJLtN: case OpJLeN: case OpJGtN: case OpJGeN:
+		return reg==a? GenRegRead : GenRegNone;
+	case OpJSame: case OpJDiff: case OpGetMeth: case OpGetProp:
+		return (reg==a || reg==a+1)? GenRegRead : GenRegNone;
+	case OpSetProp:
+		return (reg>=a && reg<=a+2)? GenRegRead : GenRegNone;
+	case OpLoadStd: case OpLoadLitReg:
+		return reg==b? GenRegRead : (reg==a || reg==a+1)? GenRegSet : GenRegNone;
+	case OpNewClosure:
+		return (reg>=a && reg<a+b)? GenRegRead : GenRegNone;
+	case OpEachPrep:
+		return (reg==b || reg>=a)? GenRegRead : GenRegNone;
+	case OpEachSplat:
+		return reg==a? GenRegRead : (reg==a+1 || reg==a+2)? GenRegSet : GenRegNone;
+	case OpAdd: case OpSub: case OpMul: case OpDiv:
+		return (reg==b || reg==c)? GenRegRead : reg==a? GenRegSet : GenRegNone;
+	case OpRocket:
+		return (reg==b || reg==c)? GenRegRead : GenRegNone;
+	case OpReturn:
+		return (reg>=a && (b==BCVARRET || reg<a+b))? GenRegRead : GenRegNone;
+	// Calls and yields may use every register from A up
+	default:
+		return reg>=a? GenRegRead : GenRegNone;
+	}
+}
+
+/** Does instruction op jump (by its sBx)? */
+#define genIsJump(op) (((op)>=OpJump && (op)<=OpJDiff) || (op)==OpForPrep || (op)==OpForLoop || (op)==OpSwitch)
+
+/** Most instructions genRegDead will look at before giving up */
+#define GENDEADMAX 48
+
+/** Is register reg's value unused on every path starting at instruction ip?
+ * Uncertain cases (including looking too far) count as used. */
+bool genRegDead(BMethodInfo *meth, AuintIdx ip, BCReg reg) {
+	AuintIdx seen[GENDEADMAX], todo[GENDEADMAX];
+	int nseen = 0, ntodo = 0;
+	todo[ntodo++] = ip;
+	while (ntodo) {
+		AuintIdx p = todo[--ntodo];
+		for (;;) {
+			int k;
+			for (k=0; k<nseen && seen[k]!=p; k++);
+			if (k<nseen)
+				break; // Already known to not use it from here
+			if (p>=meth->size || nseen==GENDEADMAX)
+				return false;
+			seen[nseen++] = p;
+			Instruction i = meth->code[p];
+			int use = genRegUse(i, reg);
+			if (use==GenRegRead)
+				return false;
+			if (use==GenRegSet || bc_op(i)==OpReturn || bc_op(i)==OpTailCall)
+				break;
+			if (bc_op(i)==OpSwitch)
+				return false; // Its Index's destinations are not followed
+			if (genIsJump(bc_op(i))) {
+				if (bc_op(i)==OpJump) {
+					p += 1 + bc_j(i);
+					continue;
+				}
+				if (ntodo==GENDEADMAX)
+					return false;
+				todo[ntodo++] = p + 1 + bc_j(i);
+			}
+			p++;
+		}
+	}
+	return true;
+}
+
+/** Mark each destination in the Index of the Switch at ip as a jump's destination */
+void genSwitchTargets(BMethodInfo *meth, AuintIdx ip, char *target) {
+	Value key, val;
+	AuintIdx pos = 0;
+	while ((pos = tblIterate(meth->lits[bc_ax(meth->code[ip+1])], pos, &key, &val)))
+		target[toAint(val)] = 1;
+}
+
+/** An instruction that does nothing (jump to next), left behind by genOptimize and then removed */
+#define GENNOP ((Instruction)BCINS_AJ(OpJump, 0, 0))
+
+/** Improve a method's generated code with a peephole pass:
+ * - Copies into a temporary register used only once are folded away: a LoadReg, LoadLit,
+ *   LoadPrim or GetGlobal followed by a LoadReg from its temporary loads directly into the
+ *   LoadReg's destination. A LoadReg into a temporary tested by JTrue/JFalse/JNull/JNNull
+ *   has the jump test the original register. LoadReg to the same register vanishes.
+ * - Rocket compares its local operands directly, rather than copies of them.
+ * - LoadLit of a method's symbol followed by LoadReg of its self becomes LoadLitReg.
+ * - Jumps to unconditional jumps go straight to the final destination, and
+ *   unconditional jumps to the very next instruction are removed.
+ * - Unreachable code after a return or unconditional jump is removed.
+ * Instructions are only rewritten when no jump lands inside the sequence.
+ * OpExtraArg stays right after its call site, as does the jump after OpRocket. */
+void genOptimize(CompInfo *comp) {
+	Value th = comp->th;
+	BMethodInfo *meth = comp->method;
+	Instruction *code = meth->code;
+	AuintIdx size = meth->size;
+	AuintIdx p;
+
+	// Mark every instruction that is a jump's destination
+	char *target = NULL;
+	mem_reallocvector(th, target, 0, size+1, char);
+	for (p=0; p<=size; p++)
+		target[p] = 0;
+	for (p=0; p<size; p++) {
+		if (genIsJump(bc_op(code[p])) && p+1+bc_j(code[p])<=size)
+			target[p+1+bc_j(code[p])] = 1;
+		if (bc_op(code[p])==OpSwitch)
+			genSwitchTargets(meth, p, target);
+	}
+
+	// Fold instruction sequences, leaving no-ops behind
+	for (p=0; p<size; p++) {
+		Instruction i = code[p];
+		BCOp op = bc_op(i);
+		Instruction next = p+1<size? code[p+1] : GENNOP;
+
+		// LoadReg a, a
+		if (op==OpLoadReg && bc_a(i)==bc_b(i))
+			code[p] = GENNOP;
+
+		// X t, ...; LoadReg r, t  =>  X r, ...
+		else if ((op==OpLoadReg || op==OpLoadLit || op==OpLoadPrim || op==OpGetGlobal)
+			&& bc_op(next)==OpLoadReg && bc_b(next)==bc_a(i) && bc_a(next)!=bc_a(i)
+			&& !target[p+1] && genRegDead(meth, p+2, bc_a(i))) {
+			code[p] = setbc_a(code[p], bc_a(next));
+			code[p+1] = GENNOP;
+			p--; // Its new form may fold again
+		}
+
+		// LoadReg t, r; JFalse t  =>  JFalse r (also JTrue, JNull, JNNull)
+		else if (op==OpLoadReg && bc_a(i)!=bc_b(i)
+			&& (bc_op(next)==OpJFalse || bc_op(next)==OpJTrue || bc_op(next)==OpJNull || bc_op(next)==OpJNNull)
+			&& bc_a(next)==bc_a(i) && !target[p+1]
+			&& genRegDead(meth, p+2, bc_a(i)) && genRegDead(meth, p+2+bc_j(next), bc_a(i))) {
+			code[p+1] = setbc_a(code[p+1], bc_b(i));
+			code[p] = GENNOP;
+		}
+
+		// LoadLit a, sym; LoadReg a+1, r  =>  LoadLitReg a, r, sym
+		else if (op==OpLoadLit && bc_bx(i)<=BCMAX_C && bc_op(next)==OpLoadReg
+			&& bc_a(next)==bc_a(i)+1 && bc_b(next)!=bc_a(i) && !target[p+1]) {
+			code[p] = BCINS_ABC(OpLoadLitReg, bc_a(i), bc_b(next), bc_bx(i));
+			code[p+1] = GENNOP;
+		}
+
+		// LoadReg a+1, x; ...; Rocket a, a+1, a+2  =>  Rocket a, x, a+2 (likewise for a+2)
+		else if (op==OpRocket && !target[p] && genRegDead(meth, p+1, bc_a(i)+1) && genRegDead(meth, p+1, bc_a(i)+2)) {
+			for (AuintIdx back = 1; back<=2 && back<=p; back++) {
+				Instruction ld = code[p-back];
+				if (target[p-back+1] || (bc_op(ld)!=OpLoadReg && bc_op(ld)!=OpLoadLit)
+					|| (bc_a(ld)!=bc_a(i)+1 && bc_a(ld)!=bc_a(i)+2))
+					break;
+				if (bc_op(ld)==OpLoadReg && bc_b(ld)<bc_a(i)) {
+					if (bc_a(ld)==bc_a(i)+1 && bc_b(code[p])==bc_a(i)+1)
+						code[p] = setbc_b(code[p], bc_b(ld));
+					else if (bc_a(ld)==bc_a(i)+2 && bc_c(code[p])==bc_a(i)+2)
+						code[p] = setbc_c(code[p], bc_b(ld));
+					else
+						break;
+					code[p-back] = GENNOP;
+				}
+			}
+		}
+	}
+
+	// Thread jumps to unconditional jumps (which includes no-ops)
+	for (p=0; p<size; p++) {
+		Instruction i = code[p];
+		if (!genIsJump(bc_op(i)) || i==GENNOP)
+			continue;
+		AuintIdx dest = p+1+bc_j(i);
+		for (int hops=0; hops<16 && dest<size && bc_op(code[dest])==OpJump && dest!=p; hops++)
+			dest = dest+1+bc_j(code[dest]);
+		if (dest<=size)
+			code[p] = setbc_j(code[p], (int)dest-(int)(p+1));
+	}
+
+	// Remove code that follows a return or unconditional jump, up to the next jump destination
+	for (p=0; p<=size; p++)
+		target[p] = 0;
+	for (p=0; p<size; p++) {
+		if (genIsJump(bc_op(code[p])) && code[p]!=GENNOP && p+1+bc_j(code[p])<=size)
+			target[p+1+bc_j(code[p])] = 1;
+		if (bc_op(code[p])==OpSwitch)
+			genSwitchTargets(meth, p, target);
+	}
+	bool dead = false;
+	for (p=0; p<size; p++) {
+		Instruction i = code[p];
+		if (target[p])
+			dead = false;
+		if (dead)
+			code[p] = GENNOP;
+		else if (i!=GENNOP && (bc_op(i)==OpJump || bc_op(i)==OpReturn || bc_op(i)==OpTailCall))
+			dead = true;
+	}
+
+	// Renumber instructions without no-ops and unconditional jumps to the next instruction
+	AuintIdx *newip = NULL;
+	mem_reallocvector(th, newip, 0, size+1, AuintIdx);
+	AuintIdx n = 0;
+	for (p=0; p<size; p++) {
+		newip[p] = n;
+		Instruction i = code[p];
+		if (bc_op(i)==OpJump) {
+			AuintIdx dest = p+1+bc_j(i);
+			AuintIdx q = p+1;
+			while (q<dest && q<size && code[q]==GENNOP)
+				q++;
+			if (q==dest) {
+				code[p] = GENNOP;
+				continue;
+			}
+		}
+		n++;
+	}
+	newip[size] = n;
+
+	// Compact the code, fixing jumps to their destinations' new positions
+	for (p=0; p<size; p++) {
+		Instruction i = code[p];
+		if (i==GENNOP)
+			continue;
+		if (genIsJump(bc_op(i)))
+			i = setbc_j(i, (int)newip[p+1+bc_j(i)]-(int)(newip[p]+1));
+		if (bc_op(i)==OpSwitch) {
+			Value tbl = meth->lits[bc_ax(code[p+1])];
+			Value key, val;
+			AuintIdx pos = 0;
+			while ((pos = tblIterate(tbl, pos, &key, &val)))
+				tblSet(th, tbl, key, anInt(newip[toAint(val)]));
+		}
+		code[newip[p]] = i;
+	}
+	meth->size = n;
+
+	mem_freearray(th, newip, size+1);
+	mem_freearray(th, target, size+1);
+}
+
 /* Generate a complete byte-code method by walking the 
  * Abstract Syntax Tree generated by the parser */
 void genBMethod(CompInfo *comp) {
@@ -986,11 +1497,39 @@ void genBMethod(CompInfo *comp) {
 	// Generate the method's code based on AST
 	int nbrnull = comp->method->nbrlocals - methodNParms(comp->method);
 	if (nbrnull>0) // Initialize non-parm locals to null
-		genAddInstr(comp, BCINS_ABC(OpLoadNulls, methodNParms(comp->method), nbrnull, 0));
+		genAddInstr(comp, BCINS_ABC(OpLoadNulls, methodNParms(comp->method), nbrnull-1, 0));
 	genStmts(comp, astGet(th, comp->ast, 2)); // Generate code for parameter defaults
 	Value aststmts = astGet(th, comp->ast, 3);
 	genFixReturns(comp, aststmts); // Turn implicit returns into explicit returns
 	genStmts(comp, aststmts); // Generate method's code block
+	genOptimize(comp); // Peephole improvements
+
+	// Allocate call sites' property caches, all initially stale
+	if (comp->method->nbrpropcache>0) {
+		mem_reallocvector(th, comp->method->propcache, 0, comp->method->nbrpropcache, PropCache);
+		for (AuintIdx i=0; i<comp->method->nbrpropcache; i++) {
+			comp->method->propcache[i].epoch = 0;
+			comp->method->propcache[i].nbrentries = 0;
+		}
+	}
+
+	// Code that fails verification is never run, so that is a compile error.
+	// Verified methods with only fixed parameters (and no yielder) take the fast call path.
+	if (!methodVerify(th, comp->method))
+		lexLog(comp->lex, "Generated method failed bytecode verification, so will not run");
+	else if (!(methodFlags(comp->method) & (METHOD_FLG_VARPARM | METHOD_FLG_YIELDER)))
+		methodFlags(comp->method) |= METHOD_FLG_FASTCALL;
+
+	// A yielder can only yield from its own frame, so one with only fixed parameters can
+	// run that frame on its caller's thread, unless it wants its own 'context' or 'selfmethod'
+	if ((methodFlags(comp->method) & (METHOD_FLG_VARPARM | METHOD_FLG_YIELDER)) == METHOD_FLG_YIELDER) {
+		AuintIdx ip;
+		for (ip = 0; ip < comp->method->size; ip++)
+			if (bc_op(comp->method->code[ip]) == OpLoadContext)
+				break;
+		if (ip == comp->method->size)
+			methodFlags(comp->method) |= METHOD_FLG_STACKLESS;
+	}
 }
 
 #ifdef __cplusplus
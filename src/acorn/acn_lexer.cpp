@@ -53,6 +53,7 @@ Value newLex(Value th, Value *dest, Value src, Value url) {
 	lex->insertSemi = false;
 	lex->undentcont = false;
 	lex->optype = 0;
+	lex->opredef = -1;
 	return (Value) lex;
 }
 
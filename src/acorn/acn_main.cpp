@@ -53,6 +53,7 @@ Value newCompiler(Value th, Value *dest, Value src, Value url) {
 
 	comp->nextreg = 0;
 	comp->whileBegIp = -1;
+	comp->whileContIp = BCNO_JMP;
 	comp->forcelocal = false;
 
 	return *dest;
@@ -76,6 +77,7 @@ int acn_newmethod(Value th) {
 	// Create compiler context, then parse source to AST
 	CompInfo* comp = (CompInfo*) pushCompiler(th, pgmsrc, baseurl);
 	parseProgram(comp);
+	optProgram(comp);
 #ifdef COMPILERLOG
 	Value aststr = pushSerialized(th, comp->ast);
 	vmLog("Resulting AST is: %s", toStr(aststr));
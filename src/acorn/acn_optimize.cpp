@@ -0,0 +1,411 @@
+/** Optimizer for Acorn compiler: simplifies a method's AST before byte-code is generated.
+ *
+ * Operators applied to Integer and Float literals are folded into a literal, as are
+ * 'not', 'and', 'or', '?' and comparisons (including of Text) whose operands become literals.
+ * Operators on Text are not folded, as each run must make its own new (mutable) Text.
+ * 'if', 'while' and 'match' clauses whose outcome is then known are resolved,
+ * dropping any clause that can never run.
+ *
+ * Since operators are methods that may be redefined, folding only runs the core
+ * (C) operator methods of the literal's type, and only when the source being compiled
+ * has no Symbol literal naming one of those operators (e.g., '+': [x] ...).
+ *
+ * @file
+ *
+ * This source file is part of avm - Acorn Virtual Machine.
+ * See Copyright Notice in avm.h
+ */
+
+#include "acorn.h"
+#include <string.h>
+
+#ifdef __cplusplus
+namespace avm {
+extern "C" {
+#endif
+
+/** Get a value within the AST segment */
+#define astGet(th, astseg, idx) (arrGet(th, astseg, idx))
+
+/** Return true if the AST segment is a literal */
+#define optIsLit(th, astseg) (isArr(astseg) && astGet(th, astseg, 0)==vmlit(SymLit))
+
+/** The value of a literal AST segment */
+#define optLitVal(th, astseg) (astGet(th, astseg, 1))
+
+/** Return true if literal's core operator methods may be run while compiling */
+#define optIsCoreVal(v) (isInt(v) || isFloat(v) || isStr(v))
+
+/** Operator methods that may be run on literals while compiling (all are side-effect free) */
+static const char *optOps[] = {"+", "-", "*", "/", "%", "<=>", "~~", NULL};
+
+// Found in acn_gen.cpp
+bool hasNoBool(Value th, Value astseg);
+
+void optExp(CompInfo *comp, Value parent, AuintIdx idx, bool truth);
+void optStmts(CompInfo *comp, Value astseg);
+
+/** Replace the value at idx in AST segment parent with a literal segment for val */
+void optSetLit(Value th, Value parent, AuintIdx idx, Value val) {
+	Value litseg = pushArray(th, aNull, 2);
+	arrAdd(th, litseg, vmlit(SymLit));
+	arrAdd(th, litseg, val);
+	arrSet(th, parent, idx, litseg);
+	popValue(th);
+}
+
+/** Replace the value at idx in AST segment parent with one that evaluates to true or false */
+void optSetBool(Value th, Value parent, AuintIdx idx) {
+	Value astseg = astGet(th, parent, idx);
+	if (optIsLit(th, astseg)) {
+		optSetLit(th, parent, idx, isFalse(optLitVal(th, astseg))? aFalse : aTrue);
+		return;
+	}
+	// ('not', ('not', exp)) is generated as a conditional jump that loads true or false
+	Value notseg = pushArray(th, aNull, 2);
+	arrAdd(th, notseg, vmlit(SymNot));
+	arrAdd(th, notseg, astseg);
+	Value notnotseg = pushArray(th, aNull, 2);
+	arrAdd(th, notnotseg, vmlit(SymNot));
+	arrAdd(th, notnotseg, notseg);
+	arrSet(th, parent, idx, notnotseg);
+	popValue(th);
+	popValue(th);
+}
+
+/** Run the core operator method 'opsym' on literals self and parm while compiling.
+ * Return true if it ran, leaving its result on the stack. Otherwise, return false. */
+bool optCallOp(CompInfo *comp, Value self, Value opsym, Value parm) {
+	Value th = comp->th;
+	if (comp->lex->opredef!=0 || !isSym(opsym) || !optIsCoreVal(self) || !optIsCoreVal(parm))
+		return false;
+	const char **opnm = optOps;
+	while (*opnm && strcmp(*opnm, toStr(opsym)))
+		opnm++;
+	if (*opnm==NULL || ((isStr(self) || isStr(parm)) && opsym!=vmlit(SymRocket) && opsym!=vmlit(SymMatchOp))
+		|| (isStr(self) && !isStr(parm)))
+		return false;
+
+	// Only a core type's C method is sure to be the operator being compiled for
+	Value meth = getProperty(th, self, opsym);
+	if (!isMethod(meth) || !isCMethod(meth))
+		return false;
+	pushValue(th, meth);
+	pushValue(th, self);
+	pushValue(th, parm);
+	getCall(th, 2, 1);
+	return true;
+}
+
+/** Fold a comparison, whose operands are literals, into true or false */
+void optCompare(CompInfo *comp, Value parent, AuintIdx idx) {
+	Value th = comp->th;
+	Value astseg = astGet(th, parent, idx);
+	Value op = astGet(th, astseg, 0);
+	Value x = optLitVal(th, astGet(th, astseg, 1));
+	Value y = optLitVal(th, astGet(th, astseg, 2));
+
+	// '===' compares values, which can only be known for literals that are not objects
+	if (op == vmlit(SymEquiv)) {
+		if (!isPtr(x) && !isPtr(y))
+			optSetLit(th, parent, idx, isSame(x, y)? aTrue : aFalse);
+		return;
+	}
+
+	// The others are based on '<=>', as evaluated by OpRocket and its conditional jump
+	if (!optCallOp(comp, x, vmlit(SymRocket), y))
+		return;
+	Value cmp = getFromTop(th, 0);
+	bool result;
+	if (op == vmlit(SymEq)) result = cmp==anInt(0);
+	else if (op == vmlit(SymNe)) result = cmp!=anInt(0);
+	else if (op == vmlit(SymLt)) result = isInt(cmp) && toAint(cmp)<0;
+	else if (op == vmlit(SymLe)) result = isInt(cmp) && toAint(cmp)<=0;
+	else if (op == vmlit(SymGt)) result = isInt(cmp) && toAint(cmp)>0;
+	else result = isInt(cmp) && toAint(cmp)>=0;
+	popValue(th);
+	optSetLit(th, parent, idx, result? aTrue : aFalse);
+}
+
+/** Simplify 'and' or 'or' by dropping literal operands that do not decide its outcome,
+ * and those after the literal operand that does. */
+void optLogic(CompInfo *comp, Value parent, AuintIdx idx, bool truth) {
+	Value th = comp->th;
+	Value astseg = astGet(th, parent, idx);
+	bool isAnd = astGet(th, astseg, 0)==vmlit(SymAnd);
+	// A 'pure' and/or's value is that of the operand that decided it. Otherwise it is true or false.
+	bool pure = hasNoBool(th, astseg);
+	AuintIdx segi;
+	for (segi = 1; segi < getSize(astseg); segi++)
+		optExp(comp, astseg, segi, truth || !pure);
+
+	segi = 1;
+	while (segi < getSize(astseg)) {
+		Value opnd = astGet(th, astseg, segi);
+		if (optIsLit(th, opnd) && isFalse(optLitVal(th, opnd))==isAnd) {
+			arrSetSize(th, astseg, segi+1); // This literal decides: later operands never run
+			break;
+		}
+		else if (optIsLit(th, opnd) && segi < getSize(astseg)-1)
+			arrDel(th, astseg, segi, 1);
+		else
+			segi++;
+	}
+
+	if (getSize(astseg)==2)
+		arrSet(th, parent, idx, astGet(th, astseg, 1));
+	if (!pure && !truth && (getSize(astseg)==2 || hasNoBool(th, astseg)))
+		optSetBool(th, parent, idx);
+}
+
+/** Fold the properties of an lval, but not the lval itself */
+void optLval(CompInfo *comp, Value lval) {
+	Value th = comp->th;
+	if (!isArr(lval))
+		return;
+	Value op = astGet(th, lval, 0);
+	if (op==vmlit(SymComma)) {
+		for (AuintIdx segi = 1; segi < getSize(lval); segi++)
+			optLval(comp, astGet(th, lval, segi));
+	}
+	else if (op==vmlit(SymActProp) || op==vmlit(SymRawProp) || op==vmlit(SymCallProp)) {
+		for (AuintIdx segi = 1; segi < getSize(lval); segi++)
+			optExp(comp, lval, segi, false);
+	}
+}
+
+/** Fold the expression at idx in AST segment parent.
+ * truth is true if only whether its value is true or false matters. */
+void optExp(CompInfo *comp, Value parent, AuintIdx idx, bool truth) {
+	Value th = comp->th;
+	Value astseg = astGet(th, parent, idx);
+	if (!isArr(astseg))
+		return;
+	Value op = astGet(th, astseg, 0);
+	AuintIdx segi;
+
+	// Property use or method call: fold parameters, then any operator on literals
+	if (op==vmlit(SymCallProp) || op==vmlit(SymActProp) || op==vmlit(SymRawProp)) {
+		for (segi = 1; segi < getSize(astseg); segi++)
+			optExp(comp, astseg, segi, false);
+		Value propseg = astGet(th, astseg, 2);
+		if (op==vmlit(SymCallProp) && getSize(astseg)==4 && optIsLit(th, propseg)
+			&& optIsLit(th, astGet(th, astseg, 1)) && optIsLit(th, astGet(th, astseg, 3))
+			&& optCallOp(comp, optLitVal(th, astGet(th, astseg, 1)), optLitVal(th, propseg), optLitVal(th, astGet(th, astseg, 3)))) {
+			optSetLit(th, parent, idx, getFromTop(th, 0));
+			popValue(th);
+		}
+	}
+	else if (op==vmlit(SymComma)) {
+		for (segi = 1; segi < getSize(astseg); segi++)
+			optExp(comp, astseg, segi, false);
+	}
+	else if (op==vmlit(SymAssgn)) {
+		optLval(comp, astGet(th, astseg, 1));
+		optExp(comp, astseg, 2, false);
+	}
+	else if (op==vmlit(SymOrAssgn) || op==vmlit(SymYield)) {
+		optExp(comp, astseg, getSize(astseg)-1, false);
+	}
+	else if (op==vmlit(SymClosure)) {
+		optExp(comp, astseg, 2, false);
+	}
+	// ('{}', exp, localvars, usingop, block)
+	else if (op==vmlit(SymThisBlock)) {
+		optExp(comp, astseg, 1, false);
+		optExp(comp, astseg, 3, false);
+		optStmts(comp, astGet(th, astseg, 4));
+	}
+	else if (op==vmlit(SymNot)) {
+		optExp(comp, astseg, 1, true);
+		Value opnd = astGet(th, astseg, 1);
+		if (optIsLit(th, opnd))
+			optSetLit(th, parent, idx, isFalse(optLitVal(th, opnd))? aTrue : aFalse);
+	}
+	else if (op==vmlit(SymAnd) || op==vmlit(SymOr)) {
+		optLogic(comp, parent, idx, truth);
+	}
+	// Ternary: ('?', cond, trueexp, falseexp)
+	else if (op==vmlit(SymQuestion)) {
+		optExp(comp, astseg, 1, true);
+		optExp(comp, astseg, 2, truth);
+		optExp(comp, astseg, 3, truth);
+		Value cond = astGet(th, astseg, 1);
+		if (optIsLit(th, cond))
+			arrSet(th, parent, idx, astGet(th, astseg, isFalse(optLitVal(th, cond))? 3 : 2));
+	}
+	else if (op==vmlit(SymEquiv) || op==vmlit(SymMatchOp)
+		|| op==vmlit(SymEq) || op==vmlit(SymNe)
+		|| op==vmlit(SymGt) || op==vmlit(SymGe) || op==vmlit(SymLt) || op==vmlit(SymLe)) {
+		optExp(comp, astseg, 1, false);
+		optExp(comp, astseg, 2, false);
+		if (op!=vmlit(SymMatchOp) && optIsLit(th, astGet(th, astseg, 1)) && optIsLit(th, astGet(th, astseg, 2)))
+			optCompare(comp, parent, idx);
+	}
+}
+
+/** Simplify 'if': ('if', cond, localvars, block, ..., 'else', localvars, block).
+ * Clauses whose literal condition is false are dropped. One whose condition is true becomes
+ * the 'else' clause, dropping all after it. Return false if no clauses are left. */
+bool optIf(CompInfo *comp, Value astseg) {
+	Value th = comp->th;
+	AuintIdx segi = 1;
+	while (segi < getSize(astseg)) {
+		if (astGet(th, astseg, segi) != vmlit(SymElse))
+			optExp(comp, astseg, segi, true);
+		optStmts(comp, astGet(th, astseg, segi+2));
+		Value cond = astGet(th, astseg, segi);
+		if (cond==vmlit(SymElse) || (optIsLit(th, cond) && !isFalse(optLitVal(th, cond)))) {
+			arrSet(th, astseg, segi, vmlit(SymElse));
+			arrSetSize(th, astseg, segi+3);
+			break;
+		}
+		else if (optIsLit(th, cond))
+			arrDel(th, astseg, segi, 3);
+		else
+			segi += 3;
+	}
+	return getSize(astseg) > 1;
+}
+
+/** Return the outcome of matching a literal value to a 'with' pattern using the core '~~':
+ * 1 for a match, 0 for no match and -1 if it cannot be known until run time. */
+int optMatchWith(CompInfo *comp, Value val, Value pattern) {
+	Value th = comp->th;
+	if (isArr(pattern) && astGet(th, pattern, 0)==vmlit(SymComma)) {
+		int result = 0;
+		for (AuintIdx segi = 1; segi < getSize(pattern) && result==0; segi++)
+			result = optMatchWith(comp, val, astGet(th, pattern, segi));
+		return result;
+	}
+	if (!optIsLit(th, pattern) || !optCallOp(comp, optLitVal(th, pattern), vmlit(SymMatchOp), val))
+		return -1;
+	int result = isFalse(getFromTop(th, 0))? 0 : 1;
+	popValue(th);
+	return result;
+}
+
+/** Simplify 'match': ('match', exp, usingop, (pattern, localvars, nbrinto, block)..., 'else', localvars, 0, block).
+ * When matching a literal using '~~', 'with' clauses that never match are dropped. All clauses
+ * after one that always matches are dropped, and it becomes the 'else' clause (if it has no 'into'). */
+void optMatch(CompInfo *comp, Value astseg) {
+	Value th = comp->th;
+	optExp(comp, astseg, 1, false);
+	optExp(comp, astseg, 2, false);
+	Value val = astGet(th, astseg, 1);
+	bool litmatch = optIsLit(th, val) && astGet(th, astseg, 2)==vmlit(SymMatchOp);
+	AuintIdx segi = 3;
+	while (segi < getSize(astseg)) {
+		Value pattern = astGet(th, astseg, segi);
+		if (isArr(pattern) && astGet(th, pattern, 0)==vmlit(SymComma)) {
+			for (AuintIdx pati = 1; pati < getSize(pattern); pati++)
+				optExp(comp, pattern, pati, false);
+		}
+		else if (pattern != vmlit(SymElse))
+			optExp(comp, astseg, segi, false);
+		optStmts(comp, astGet(th, astseg, segi+3));
+		pattern = astGet(th, astseg, segi);
+		int matched = pattern==vmlit(SymElse)? 1 : litmatch? optMatchWith(comp, optLitVal(th, val), pattern) : -1;
+		if (matched==1) {
+			if (astGet(th, astseg, segi+2)==anInt(0))
+				arrSet(th, astseg, segi, vmlit(SymElse));
+			arrSetSize(th, astseg, segi+4);
+			break;
+		}
+		else if (matched==0)
+			arrDel(th, astseg, segi, 4);
+		else
+			segi += 4;
+	}
+}
+
+/** Simplify the statement at idx in AST segment parent.
+ * Return false if it does nothing (and so may be removed). */
+bool optStmt(CompInfo *comp, Value parent, AuintIdx idx) {
+	Value th = comp->th;
+	Value aststmt = astGet(th, parent, idx);
+	if (!isArr(aststmt))
+		return true;
+	Value op = astGet(th, aststmt, 0);
+	if (op==vmlit(SymIf))
+		return optIf(comp, aststmt);
+	else if (op==vmlit(SymMatch))
+		optMatch(comp, aststmt);
+	// ('while', localvars, cond, block)
+	else if (op==vmlit(SymWhile)) {
+		optExp(comp, aststmt, 2, true);
+		optStmts(comp, astGet(th, aststmt, 3));
+		Value cond = astGet(th, aststmt, 2);
+		return !optIsLit(th, cond) || !isFalse(optLitVal(th, cond));
+	}
+	// ('each', localvars, nbrvals, iterator, block)
+	else if (op==vmlit(SymEach)) {
+		optExp(comp, aststmt, 3, false);
+		optStmts(comp, astGet(th, aststmt, 4));
+	}
+	// ('do', localvars, exp, block)
+	else if (op==vmlit(SymDo)) {
+		optExp(comp, aststmt, 2, false);
+		optStmts(comp, astGet(th, aststmt, 3));
+	}
+	else if (op==vmlit(SymReturn) || op==vmlit(SymYield))
+		optExp(comp, aststmt, 1, false);
+	else
+		optExp(comp, parent, idx, false);
+	return true;
+}
+
+/** Simplify a block's statements: (';', stmt, ...) */
+void optStmts(CompInfo *comp, Value astseg) {
+	Value th = comp->th;
+	if (!isArr(astseg) || astGet(th, astseg, 0)!=vmlit(SymSemicolon))
+		return;
+	AuintIdx segi = 1;
+	while (segi < getSize(astseg)) {
+		if (optStmt(comp, astseg, segi))
+			segi++;
+		// Remove a statement that does nothing, unless the block's (implicit return) value is from it
+		else if (segi < getSize(astseg)-1)
+			arrDel(th, astseg, segi, 1);
+		else
+			optSetLit(th, astseg, segi++, aNull);
+	}
+}
+
+/** Does the source have a Symbol literal (e.g., '+') naming an operator that optCallOp might run?
+ * All of its tokens are checked, not just this method's AST, because a method
+ * is compiled as soon as it is parsed, before the rest of the source. */
+bool optNamesOp(CompInfo *comp) {
+	Value th = comp->th;
+	Value lexval;
+	newLex(th, &lexval, comp->lex->source, comp->lex->url);
+	pushValue(th, lexval);
+	LexInfo *lex = (LexInfo*) lexval;
+	bool named = false;
+	for (lexGetNextToken(lex); lex->toktype!=Eof_Token && !named; lexGetNextToken(lex)) {
+		if (lex->toktype==Lit_Token && isSym(lex->token)) {
+			for (const char **opnm = optOps; *opnm && !named; opnm++)
+				named = strcmp(toStr(lex->token), *opnm)==0;
+		}
+	}
+	popValue(th);
+	return named;
+}
+
+/* Optimize a parsed Acorn method's AST */
+void optProgram(CompInfo *comp) {
+	Value th = comp->th;
+
+	// Might the source redefine an operator we could run?
+	if (comp->lex->opredef<0)
+		comp->lex->opredef = optNamesOp(comp);
+
+	// AST: ('method', localvars, parminitstmts, statements)
+	optStmts(comp, astGet(th, comp->ast, 2));
+	optStmts(comp, astGet(th, comp->ast, 3));
+}
+
+#ifdef __cplusplus
+} // extern "C"
+} // namespace avm
+#endif
@@ -82,10 +82,14 @@ void mem_init(VmInfo *vm) {
 
 	vm->gcnbrnew = 0;
 	vm->gcnbrold = 0;
+	vm->gcnbrlive = 0;
 	vm->gctrigger = -vm->gcnewtrigger;
 	vm->gcstepdelay = 1;
 
 	vm->totalbytes = sizeof(VmInfo);
+#ifndef AVM_NONURSERY
+	mem_nurseryinit(vm);
+#endif
 }
 
 /* ====================================================================== */
@@ -154,6 +158,9 @@ void mem_sweepfree(Value th, MemInfo *mb);
  * Doing this mark check would be onerous for the very common scenario of putting temporary values into the stack.
  * With thread parents, we employ a different strategy:
  * re-marking all stacks in an uninterrupted (atomic) fashion at the end of the marking phase.
+ * In generational mode, old objects stay black, so this check is also the remembered set:
+ * a young object stored into an old one is marked (put on the gray list) rather than swept,
+ * which is why a generational cycle need not mark from the root.
  */
 void mem_markChk(Value th, Value parent, Value val) {
 	if (isPtr(val) && vm(th)->gcbarrieron
@@ -354,9 +361,12 @@ MemInfo **mem_sweeplist(Value th, MemInfo **p, bool doall) {
 			if (testbits(marked, tostop))
 				return NULL;  /* stop sweeping this list */
 			// In gen mode, count new's converted to old,
-			// used to trigger a full GC cycle
+			// used to trigger a full GC cycle. A full cycle's survivors
+			// are all made old, but do not count, or the next cycle would be full too.
 			vm(th)->gcstepunits -= GCSWEEPLIVECOST;
-			if (tostop)
+			if (!isgenerational(th))
+				vm(th)->gcnbrlive++;
+			else if (tostop)
 				vm(th)->gcnbrold++;
 			// update marks
 			curr->marked = ((marked & toclear) | toset);
@@ -372,10 +382,46 @@ MemInfo **mem_sweepwholelist(Value th, MemInfo **p) {
 	return mem_sweeplist(th, p, 1); 
 }
 
+/** Sweep the symbol in a symbol table slot. If dead, its slot is left marked as removed,
+ * so lookups still probe past it. */
+void mem_sweepsymslot(Value th, SymSlot *slot) {
+	SymTable* sym_tbl = &vm(th)->sym_table;
+	mem_sweepwholelist(th, (MemInfo**) &slot->sym);  // a list of one symbol
+	if (slot->sym == NULL) {
+		slot->sym = SymDeleted;
+		if (slot >= sym_tbl->symArray && slot < sym_tbl->symArray + sym_tbl->nbrAvail)
+			sym_tbl->nbrDeleted++;
+	}
+}
+
+/** Sweep at most count of the symbol table's slots, starting at position pos (across both arrays).
+ * \return Where we stopped sweep */
+Auint mem_sweepsymbols(Value th, Auint pos, Auint count) {
+	SymTable* sym_tbl = &vm(th)->sym_table;
+	for (; count && pos < sym_nbrslots(sym_tbl); count--, pos++) {
+		SymSlot *slot = sym_slot(sym_tbl, pos);
+		if (sym_isused(slot->sym))
+			mem_sweepsymslot(th, slot);
+	}
+	return pos;
+}
+
+/** Sweep only the symbols added since the last sweep began.
+ * In a generational cycle, all other symbols are old (and so stay alive). */
+void mem_sweepyoungsymbols(Value th) {
+	SymTable* sym_tbl = &vm(th)->sym_table;
+	for (AuintIdx i = 0; i < sym_tbl->nbrYoung; i++)
+		mem_sweepsymslot(th, sym_slotof(th, sym_tbl->young[i]));
+	sym_tbl->nbrYoung = 0;
+}
+
 /** Clean up after sweep by collapsing buffers, as needed */
 void mem_sweepcleanup(Value th) {
-	// do not change sizes in emergency
-	if (vm(th)->gcmode == GC_EMERGENCY) return;
+	// do not change sizes in emergency, but give back memory held for reuse
+	if (vm(th)->gcmode == GC_EMERGENCY) {
+		thrFreePool(th);
+		return;
+	}
 
 	// Shrink symbol table, if usage is grown too small
 	SymTable* sym_tbl = &vm(th)->sym_table;
@@ -388,10 +434,10 @@ void mem_freeAll(Value th) {
 	vm->currentwhite = WHITEBITS; // this "white" makes all objects look dead
 	vm->gcstate = GC_FULLMODE;
 	mem_sweepwholelist(th, &vm->objlist);
-	for (Auint i = 0; i < vm->sym_table.nbrAvail; i++)
-		mem_sweepwholelist(th, (MemInfo**) &vm->sym_table.symArray[i]);
+	mem_sweepsymbols(th, 0, sym_nbrslots(&vm->sym_table));
 	assert(vm->sym_table.nbrUsed == 0);
 	mem_sweepwholelist(th, &vm->threads);
+	thrFreePool(th);
 }
 
 
@@ -463,9 +509,10 @@ void mem_gconestep(Value th) {
 			else
 				vm->gcnextmode = GC_GENMODE;
 		}
-		if (vm->gcnextmode != GC_GENMODE)
+		if (vm->gcmode != GC_GENMODE || vm->gcnextmode != GC_GENMODE)
 			vm->gcnbrold = 0;
 		vm->gcnbrnew = 0;
+		vm->gcnbrlive = 0;
 
 		// Do atomic (finalization) marking
 		mem_markatomic(th);  // add what was traversed by 'atomic'
@@ -474,7 +521,17 @@ void mem_gconestep(Value th) {
 		vm->gcstate = GCSsweepsymbol;
 		vm->currentwhite = otherwhite(th);  // flip current white
 		assert(vm(th)->sweepgc == NULL);
-		vm(th)->sweepsymgc = 0;
+
+		// A generational cycle (that stays generational) need only sweep young symbols,
+		// and does so now. Otherwise, the whole symbol table is swept incrementally.
+		if (vm->gcmode == GC_GENMODE && vm->gcnextmode == GC_GENMODE) {
+			mem_sweepyoungsymbols(th);
+			vm->sweepsymgc = sym_nbrslots(&vm->sym_table);
+		}
+		else {
+			vm->sym_table.nbrYoung = 0;
+			vm->sweepsymgc = 0;
+		}
 
 		if (vm->gcnextmode == GC_FULLMODE)
 			vm->gcbarrieron = 0;
@@ -485,12 +542,9 @@ void mem_gconestep(Value th) {
 
     // Sweep unreferenced symbols first
     case GCSsweepsymbol: {
-		Auint i;
-		for (i = 0; i < GCSWEEPMAX && vm->sweepsymgc + i < vm->sym_table.nbrAvail; i++)
-			mem_sweepwholelist(th, (MemInfo**) &vm->sym_table.symArray[vm->sweepsymgc + i]);
-		vm->sweepsymgc += i;
+		vm->sweepsymgc = mem_sweepsymbols(th, vm->sweepsymgc, GCSWEEPMAX);
 		// If no more symbols to sweep, set up to sweep threads
-		if (vm->sweepsymgc >= vm->sym_table.nbrAvail) {
+		if (vm->sweepsymgc >= sym_nbrslots(&vm->sym_table)) {
 			vm->gcstate = GCSsweepthread;
 			vm(th)->sweepgc = &vm(th)->threads;
 		}
@@ -524,6 +578,13 @@ void mem_gconestep(Value th) {
 				vm->gcnbrmarks, vm->gcnbrfrees);
 #endif
 
+			// After a full cycle, the old generation may grow in proportion to what survived it
+			// before the next full cycle
+			if (!isgenerational(th)) {
+				Auint growth = (Auint) vm->gcnbrlive * GCOLDGROWTH / 100;
+				vm->gcoldtrigger = growth > GCOLDTRIGGER? (int) growth : GCOLDTRIGGER;
+			}
+
 			vm->gcstate = GCSbegin;  // finish collection
 			vm->gcmode = vm->gcnextmode;
 			vm->gcnextmode = 0;
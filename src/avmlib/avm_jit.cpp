@@ -0,0 +1,499 @@
+/** Implements translation of hot bytecode methods to native x86-64 code.
+ *
+ * See avm_jit.h for how native code and the interpreter share the work.
+ *
+ * @file
+ *
+ * This source file is part of avm - Acorn Virtual Machine.
+ * See Copyright Notice in avm.h
+ */
+
+#include "avmlib.h"
+#include <string.h>
+#include <stddef.h>
+#ifdef AVM_JIT
+#include <sys/mman.h>
+#endif
+
+#ifdef __cplusplus
+namespace avm {
+extern "C" {
+#endif
+
+#ifdef AVM_JIT
+
+bool float_almostequal(Afloat a, Afloat b);
+
+/* Native code uses these registers (System V x86-64 ABI):
+ * rbx = stkbeg, r12 = lits, r13 = th (all callee-saved), rax, rcx and rdx are scratch.
+ * The prologue saves the callee-saved registers and jumps to the requested start.
+ * Every exit loads rax with the instruction to return and jumps to the epilogue. */
+
+/** Most native bytes any instruction's template may produce */
+#define JITMAXINSTR 160
+
+/* x86-64 registers used by templates */
+#define JitRax 0
+#define JitRcx 1
+
+/* Condition codes (second byte of a near jcc) */
+#define JitJC  0x82
+#define JitJE  0x84
+#define JitJNE 0x85
+#define JitJL  0x8C
+#define JitJGE 0x8D
+#define JitJLE 0x8E
+#define JitJG  0x8F
+
+/** A jump whose rel32 must be fixed to point to an instruction's native code */
+typedef struct JitFixup {
+	Auint at;			//!< Offset of rel32 to fix
+	AuintIdx target;	//!< Instruction it jumps to
+} JitFixup;
+
+/** State of a translation underway */
+typedef struct JitState {
+	unsigned char *start;	//!< Start of native code
+	unsigned char *p;		//!< Where next native byte goes
+	unsigned char *epilog;	//!< Where native code restores registers and returns
+	JitFixup *fixups;		//!< Jumps to fix once every instruction's location is known
+	AuintIdx nbrfixups;		//!< Number of fixups
+} JitState;
+
+/** Emit a native byte */
+#define jitByte(js, b) (*(js)->p++ = (unsigned char)(b))
+
+/** Emit a 32-bit native value */
+void jitU32(JitState *js, uint32_t v) {
+	memcpy(js->p, &v, sizeof(v));
+	js->p += sizeof(v);
+}
+
+/** Emit a 64-bit native value */
+void jitU64(JitState *js, uint64_t v) {
+	memcpy(js->p, &v, sizeof(v));
+	js->p += sizeof(v);
+}
+
+/** mov reg, [rbx + vmreg*8] */
+void jitGetReg(JitState *js, int reg, AuintIdx vmreg) {
+	jitByte(js, 0x48); jitByte(js, 0x8B); jitByte(js, 0x83 | reg<<3);
+	jitU32(js, vmreg*sizeof(Value));
+}
+
+/** mov [rbx + vmreg*8], reg */
+void jitSetReg(JitState *js, int reg, AuintIdx vmreg) {
+	jitByte(js, 0x48); jitByte(js, 0x89); jitByte(js, 0x83 | reg<<3);
+	jitU32(js, vmreg*sizeof(Value));
+}
+
+/** mov reg, [r12 + lit*8] */
+void jitGetLit(JitState *js, int reg, AuintIdx lit) {
+	jitByte(js, 0x49); jitByte(js, 0x8B); jitByte(js, 0x84 | reg<<3); jitByte(js, 0x24);
+	jitU32(js, lit*sizeof(Value));
+}
+
+/** mov reg, imm64 */
+void jitImm(JitState *js, int reg, uint64_t imm) {
+	jitByte(js, 0x48); jitByte(js, 0xB8 + reg);
+	jitU64(js, imm);
+}
+
+/** cmp rax, imm32 (for Values that fit) */
+void jitCmpImm(JitState *js, Value val) {
+	jitByte(js, 0x48); jitByte(js, 0x3D);
+	jitU32(js, (uint32_t)(Auint)val);
+}
+
+/** Near jump (cc=0) or conditional jump to an instruction's native code */
+void jitJump(JitState *js, int cc, AuintIdx target) {
+	if (cc) {jitByte(js, 0x0F); jitByte(js, cc);}
+	else jitByte(js, 0xE9);
+	js->fixups[js->nbrfixups].at = js->p - js->start;
+	js->fixups[js->nbrfixups++].target = target;
+	jitU32(js, 0);
+}
+
+/** Forward jump (cc=0) or conditional jump within a template. Returns where to patch with jitLand. */
+unsigned char *jitSkip(JitState *js, int cc) {
+	if (cc) {jitByte(js, 0x0F); jitByte(js, cc);}
+	else jitByte(js, 0xE9);
+	jitU32(js, 0);
+	return js->p - 4;
+}
+
+/** Point a jitSkip jump to here */
+void jitLand(JitState *js, unsigned char *patch) {
+	uint32_t rel = (uint32_t)(js->p - (patch+4));
+	memcpy(patch, &rel, sizeof(rel));
+}
+
+/** Hand control back to the interpreter at instruction ip */
+void jitExit(JitState *js, Instruction *ip) {
+	jitImm(js, JitRax, (uint64_t)ip);
+	jitByte(js, 0xE9);
+	jitU32(js, (uint32_t)(js->epilog - (js->p+4)));
+}
+
+/** Call helper(th, stkbeg, i), which returns its result in eax */
+void jitCallHelper(JitState *js, void *helper, Instruction i) {
+	jitByte(js, 0x4C); jitByte(js, 0x89); jitByte(js, 0xEF); // mov rdi, r13
+	jitByte(js, 0x48); jitByte(js, 0x89); jitByte(js, 0xDE); // mov rsi, rbx
+	jitByte(js, 0xBA); jitU32(js, i); // mov edx, i
+	jitImm(js, JitRax, (uint64_t)helper);
+	jitByte(js, 0xFF); jitByte(js, 0xD0); // call rax
+}
+
+/** Jump to patch unless Integer and Float operators are still built in */
+unsigned char *jitFastNumOps(Value th, JitState *js) {
+	jitByte(js, 0x48); jitByte(js, 0xBA); jitU64(js, (uint64_t)&vm(th)->fastnumops); // mov rdx, &fastnumops
+	jitByte(js, 0x80); jitByte(js, 0x3A); jitByte(js, 0x00); // cmp byte [rdx], 0
+	return jitSkip(js, JitJE);
+}
+
+/** Jump to patch if reg does not hold an Integer */
+unsigned char *jitNotInt(JitState *js, int reg) {
+	jitByte(js, 0x89); jitByte(js, 0xC2 | reg<<3); // mov edx, reg
+	jitByte(js, 0x83); jitByte(js, 0xE2); jitByte(js, ValMask); // and edx, ValMask
+	jitByte(js, 0x83); jitByte(js, 0xFA); jitByte(js, ValInt); // cmp edx, ValInt
+	return jitSkip(js, JitJNE);
+}
+
+/** Helper for OpAdd, OpSub, OpMul and OpDiv on two Integers or two Floats.
+ * Returns 0 if the operator's method must be called instead. */
+int jitArith(Value th, Value *stkbeg, Instruction i) {
+	Value b = *(stkbeg + bc_b(i));
+	Value c = *(stkbeg + bc_c(i));
+	Value *rega = stkbeg + bc_a(i);
+	if (!vm(th)->fastnumops)
+		return 0;
+	if (isInt(b) && isInt(c)) {
+		switch (bc_op(i)) {
+		case OpAdd: *rega = anInt(toAint(b) + toAint(c)); break;
+		case OpSub: *rega = anInt(toAint(b) - toAint(c)); break;
+		case OpMul: *rega = anInt(toAint(b) * toAint(c)); break;
+		default: *rega = c==anInt(0)? aNull : anInt(toAint(b) / toAint(c)); break;
+		}
+	}
+	else if (isFloat(b) && isFloat(c)) {
+		switch (bc_op(i)) {
+		case OpAdd: *rega = aFloat(toAfloat(b) + toAfloat(c)); break;
+		case OpSub: *rega = aFloat(toAfloat(b) - toAfloat(c)); break;
+		case OpMul: *rega = aFloat(toAfloat(b) * toAfloat(c)); break;
+		default: *rega = aFloat(toAfloat(b) / toAfloat(c)); break;
+		}
+	}
+	else
+		return 0;
+	return 1;
+}
+
+/** Helper for OpRocket on two Integers or two Floats.
+ * Returns the comparison+2 (1, 2 or 3), or 0 if '<=>' must be called instead. */
+int jitRocket(Value th, Value *stkbeg, Instruction i) {
+	Value x = *(stkbeg + bc_b(i));
+	Value y = *(stkbeg + bc_c(i));
+	if (!vm(th)->fastnumops)
+		return 0;
+	if (isInt(x) && isInt(y))
+		return x==y? 2 : toAint(x)<toAint(y)? 1 : 3;
+	if (isFloat(x) && isFloat(y))
+		return float_almostequal(toAfloat(x), toAfloat(y))? 2 : toAfloat(x)<toAfloat(y)? 1 : 3;
+	return 0;
+}
+
+/** Helper for OpJEq .. OpJGeN: returns 1 if the jump is taken */
+int jitJumpTest(Value th, Value *stkbeg, Instruction i) {
+	Value a = *(stkbeg + bc_a(i));
+	switch (bc_op(i)) {
+	case OpJEq: return a==anInt(0);
+	case OpJEqN: return a==anInt(0) || a==aNull;
+	case OpJNe: return a!=anInt(0);
+	case OpJNeN: return a!=anInt(0) || a==aNull;
+	case OpJLt: return isInt(a) && toAint(a)<0;
+	case OpJLtN: return !isInt(a) || toAint(a)<0;
+	case OpJLe: return isInt(a) && toAint(a)<=0;
+	case OpJLeN: return !isInt(a) || toAint(a)<=0;
+	case OpJGt: return isInt(a) && toAint(a)>0;
+	case OpJGtN: return !isInt(a) || toAint(a)>0;
+	case OpJGe: return isInt(a) && toAint(a)>=0;
+	default: return !isInt(a) || toAint(a)>=0;
+	}
+}
+
+/** For each conditional jump on a <=> result (OpJEq .. OpJGeN), which results jump:
+ * bit 0 for -1, bit 1 for 0, bit 2 for 1 */
+static const unsigned char jitRocketJumps[] = {2, 5, 1, 3, 4, 6, 2, 5, 1, 3, 4, 6};
+
+/** Native jcc after 'cmp x, y' for each jitRocketJumps mask */
+static const unsigned char jitRocketCc[] = {0, JitJL, JitJE, JitJLE, JitJG, JitJNE, JitJGE};
+
+/** Generate OpAdd or OpSub i at ip: Integers inline, otherwise jitArith or back to the interpreter */
+void jitGenAddSub(Value th, JitState *js, Instruction *ip, Instruction i) {
+	jitGetReg(js, JitRax, bc_b(i));
+	jitGetReg(js, JitRcx, bc_c(i));
+	unsigned char *slow1 = jitFastNumOps(th, js);
+	unsigned char *slow2 = jitNotInt(js, JitRax);
+	unsigned char *slow3 = jitNotInt(js, JitRcx);
+	// Tagged Integers: (x+1) + (y+1) - 1 or (x+1) - (y+1) + 1
+	jitByte(js, 0x48); jitByte(js, bc_op(i)==OpAdd? 0x01 : 0x29); jitByte(js, 0xC8); // add/sub rax, rcx
+	jitByte(js, 0x48); jitByte(js, 0x83); jitByte(js, bc_op(i)==OpAdd? 0xE8 : 0xC0); jitByte(js, ValInt); // sub/add rax, ValInt
+	jitSetReg(js, JitRax, bc_a(i));
+	unsigned char *done = jitSkip(js, 0);
+	jitLand(js, slow1); jitLand(js, slow2); jitLand(js, slow3);
+	jitCallHelper(js, (void*)jitArith, i);
+	jitByte(js, 0x85); jitByte(js, 0xC0); // test eax, eax
+	unsigned char *done2 = jitSkip(js, JitJNE);
+	jitExit(js, ip);
+	jitLand(js, done); jitLand(js, done2);
+}
+
+/** Generate OpRocket followed by a conditional jump on its result.
+ * Integers are compared inline, otherwise jitRocket or back to the interpreter. */
+void jitGenRocketJump(Value th, JitState *js, Instruction *ip, Instruction i, AuintIdx idx) {
+	Instruction j = *(ip+1);
+	AuintIdx target = idx + 2 + bc_j(j);
+	unsigned char mask = jitRocketJumps[bc_op(j)-OpJEq];
+	jitGetReg(js, JitRax, bc_b(i));
+	jitGetReg(js, JitRcx, bc_c(i));
+	unsigned char *slow1 = jitFastNumOps(th, js);
+	unsigned char *slow2 = jitNotInt(js, JitRax);
+	unsigned char *slow3 = jitNotInt(js, JitRcx);
+	jitByte(js, 0x48); jitByte(js, 0x39); jitByte(js, 0xC8); // cmp rax, rcx
+	jitJump(js, jitRocketCc[mask], target);
+	jitJump(js, 0, idx+2);
+	jitLand(js, slow1); jitLand(js, slow2); jitLand(js, slow3);
+	jitCallHelper(js, (void*)jitRocket, i);
+	jitByte(js, 0x85); jitByte(js, 0xC0); // test eax, eax
+	unsigned char *fast = jitSkip(js, JitJNE);
+	jitExit(js, ip);
+	jitLand(js, fast);
+	jitByte(js, 0xBA); jitU32(js, mask<<1); // mov edx, mask<<1
+	jitByte(js, 0x0F); jitByte(js, 0xA3); jitByte(js, 0xC2); // bt edx, eax
+	jitJump(js, JitJC, target);
+	jitJump(js, 0, idx+2);
+}
+
+/** Generate native code for one instruction */
+void jitGenInstr(Value th, JitState *js, BMethodInfo *meth, AuintIdx idx) {
+	Instruction *ip = meth->runcode + idx; // Where the interpreter resumes
+	Instruction i = meth->code[idx]; // Translated in its generic form
+	AuintIdx target = idx + 1 + bc_j(i); // For jumps only
+	switch (bc_op(i)) {
+
+	case OpLoadReg:
+		jitGetReg(js, JitRax, bc_b(i));
+		jitSetReg(js, JitRax, bc_a(i));
+		break;
+
+	case OpLoadLit:
+		jitGetLit(js, JitRax, bc_bx(i));
+		jitSetReg(js, JitRax, bc_a(i));
+		break;
+
+	case OpLoadPrim:
+		jitImm(js, JitRax, (((Auint)bc_b(i)) << ValShift) + ValCons);
+		jitSetReg(js, JitRax, bc_a(i));
+		break;
+
+	case OpLoadNulls:
+		if (bc_b(i) >= 16) {
+			jitExit(js, ip);
+			break;
+		}
+		jitImm(js, JitRax, (uint64_t)aNull);
+		for (AuintIdx r = bc_a(i); r <= bc_a(i)+bc_b(i); r++)
+			jitSetReg(js, JitRax, r);
+		break;
+
+	// R(A) := value in global variable's bound cell
+	case OpGetGlobal:
+		jitGetLit(js, JitRax, bc_bx(i));
+		jitByte(js, 0x48); jitByte(js, 0x8B); jitByte(js, 0x80); jitU32(js, offsetof(ArrInfo, arr)); // mov rax, [rax+arr]
+		jitByte(js, 0x48); jitByte(js, 0x8B); jitByte(js, 0x00); // mov rax, [rax]
+		jitSetReg(js, JitRax, bc_a(i));
+		break;
+
+	case OpJump:
+		jitJump(js, 0, target);
+		break;
+
+	case OpJNull:
+	case OpJNNull:
+		jitGetReg(js, JitRax, bc_a(i));
+		jitCmpImm(js, aNull);
+		jitJump(js, bc_op(i)==OpJNull? JitJE : JitJNE, target);
+		break;
+
+	case OpJTrue: {
+		jitGetReg(js, JitRax, bc_a(i));
+		jitCmpImm(js, aFalse);
+		unsigned char *nojump1 = jitSkip(js, JitJE);
+		jitCmpImm(js, aNull);
+		unsigned char *nojump2 = jitSkip(js, JitJE);
+		jitJump(js, 0, target);
+		jitLand(js, nojump1); jitLand(js, nojump2);
+		} break;
+
+	case OpJFalse:
+		jitGetReg(js, JitRax, bc_a(i));
+		jitCmpImm(js, aFalse);
+		jitJump(js, JitJE, target);
+		jitCmpImm(js, aNull);
+		jitJump(js, JitJE, target);
+		break;
+
+	case OpJSame:
+	case OpJDiff:
+		jitGetReg(js, JitRax, bc_a(i));
+		jitGetReg(js, JitRcx, bc_a(i)+1);
+		jitByte(js, 0x48); jitByte(js, 0x39); jitByte(js, 0xC8); // cmp rax, rcx
+		jitJump(js, bc_op(i)==OpJSame? JitJE : JitJNE, target);
+		break;
+
+	case OpJEq: case OpJNe: case OpJLt: case OpJLe: case OpJGt: case OpJGe:
+	case OpJEqN: case OpJNeN: case OpJLtN: case OpJLeN: case OpJGtN: case OpJGeN:
+		jitCallHelper(js, (void*)jitJumpTest, i);
+		jitByte(js, 0x85); jitByte(js, 0xC0); // test eax, eax
+		jitJump(js, JitJNE, target);
+		break;
+
+	case OpAdd:
+	case OpSub:
+		jitGenAddSub(th, js, ip, i);
+		break;
+
+	case OpMul:
+	case OpDiv: {
+		jitCallHelper(js, (void*)jitArith, i);
+		jitByte(js, 0x85); jitByte(js, 0xC0); // test eax, eax
+		unsigned char *done = jitSkip(js, JitJNE);
+		jitExit(js, ip);
+		jitLand(js, done);
+		} break;
+
+	case OpLoadLitReg:
+		jitGetReg(js, JitRax, bc_b(i));
+		jitSetReg(js, JitRax, bc_a(i)+1);
+		jitGetLit(js, JitRax, bc_c(i));
+		jitSetReg(js, JitRax, bc_a(i));
+		break;
+
+	// Only a compare-and-branch pair is done natively
+	case OpRocket:
+		if (idx+1 < meth->size && bc_op(*(ip+1))>=OpJEq && bc_op(*(ip+1))<=OpJGeN && bc_a(*(ip+1))==bc_a(i))
+			jitGenRocketJump(th, js, ip, i, idx);
+		else
+			jitExit(js, ip);
+		break;
+
+	// Everything else is done by the interpreter
+	default:
+		jitExit(js, ip);
+		break;
+	}
+}
+
+/* Translate a method's bytecode to native code, returning its JitCode. */
+JitCode *jitCompile(Value th, BMethodInfo *meth) {
+	JitCode *jit = (JitCode*) mem_gcrealloc(th, NULL, 0, sizeof(JitCode));
+	jit->native = NULL;
+	jit->nativesz = 0;
+	jit->offsets = NULL;
+	jit->nbroffsets = 0;
+
+	// Map writable memory big enough for the largest possible translation
+	Auint sz = 64 + (meth->size+1)*JITMAXINSTR;
+	unsigned char *native = (unsigned char*) mmap(NULL, sz, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+	if (native == MAP_FAILED)
+		return jit;
+
+	JitState js;
+	js.start = js.p = native;
+	js.nbrfixups = 0;
+	js.fixups = NULL;
+	mem_reallocvector(th, js.fixups, 0, 4*meth->size, JitFixup);
+	mem_reallocvector(th, jit->offsets, 0, meth->size+1, Auint);
+	jit->nbroffsets = meth->size+1;
+
+	// Prologue: save registers, load stkbeg, lits and th, then go to start
+	jitByte(&js, 0x53); // push rbx
+	jitByte(&js, 0x41); jitByte(&js, 0x54); // push r12
+	jitByte(&js, 0x41); jitByte(&js, 0x55); // push r13
+	jitByte(&js, 0x41); jitByte(&js, 0x56); // push r14
+	jitByte(&js, 0x41); jitByte(&js, 0x57); // push r15 (keeps stack 16-byte aligned for helper calls)
+	jitByte(&js, 0x48); jitByte(&js, 0x89); jitByte(&js, 0xF3); // mov rbx, rsi
+	jitByte(&js, 0x49); jitByte(&js, 0x89); jitByte(&js, 0xD4); // mov r12, rdx
+	jitByte(&js, 0x49); jitByte(&js, 0x89); jitByte(&js, 0xFD); // mov r13, rdi
+	jitByte(&js, 0xFF); jitByte(&js, 0xE1); // jmp rcx
+
+	// Epilogue: restore registers and return the instruction in rax
+	js.epilog = js.p;
+	jitByte(&js, 0x41); jitByte(&js, 0x5F); // pop r15
+	jitByte(&js, 0x41); jitByte(&js, 0x5E); // pop r14
+	jitByte(&js, 0x41); jitByte(&js, 0x5D); // pop r13
+	jitByte(&js, 0x41); jitByte(&js, 0x5C); // pop r12
+	jitByte(&js, 0x5B); // pop rbx
+	jitByte(&js, 0xC3); // ret
+
+	// Translate every instruction, then fall off the end back to the interpreter
+	for (AuintIdx idx = 0; idx < meth->size; idx++) {
+		jit->offsets[idx] = js.p - js.start;
+		jitGenInstr(th, &js, meth, idx);
+		assert(js.p - js.start - jit->offsets[idx] <= JITMAXINSTR);
+	}
+	jit->offsets[meth->size] = js.p - js.start;
+	jitExit(&js, meth->runcode + meth->size);
+
+	// Now that all instructions are placed, fix jumps to them
+	for (AuintIdx f = 0; f < js.nbrfixups; f++) {
+		uint32_t rel = (uint32_t)(jit->offsets[js.fixups[f].target] - (js.fixups[f].at+4));
+		memcpy(js.start + js.fixups[f].at, &rel, sizeof(rel));
+	}
+	mem_freearray(th, js.fixups, 4*meth->size);
+
+	// Make it executable (and no longer writable)
+	if (mprotect(native, sz, PROT_READ|PROT_EXEC) != 0) {
+		munmap(native, sz);
+		return jit;
+	}
+	jit->native = native;
+	jit->nativesz = sz;
+	return jit;
+}
+
+/* Free a method's native code */
+void jitFree(Value th, BMethodInfo *meth) {
+	JitCode *jit = meth->jit;
+	if (jit->native)
+		munmap(jit->native, jit->nativesz);
+	if (jit->offsets)
+		mem_freearray(th, jit->offsets, jit->nbroffsets);
+	mem_free(th, jit);
+	meth->jit = NULL;
+}
+
+#else
+
+/* Without native code support, no method can be translated */
+JitCode *jitCompile(Value th, BMethodInfo *meth) {
+	JitCode *jit = (JitCode*) mem_gcrealloc(th, NULL, 0, sizeof(JitCode));
+	jit->native = NULL;
+	jit->nativesz = 0;
+	jit->offsets = NULL;
+	jit->nbroffsets = 0;
+	return jit;
+}
+
+/* Free a method's native code */
+void jitFree(Value th, BMethodInfo *meth) {
+	mem_free(th, meth->jit);
+	meth->jit = NULL;
+}
+
+#endif
+
+#ifdef __cplusplus
+} // extern "C"
+} // namespace avm
+#endif
@@ -7,12 +7,87 @@
 
 #include "avmlib.h"
 #include <stdlib.h>
+#include <string.h>
 
 #ifdef __cplusplus
 namespace avm {
 extern "C" {
 #endif
 
+#ifndef AVM_NONURSERY
+/** \file
+ * Nursery
+ * -------
+ *
+ * Most objects die young, usually by the next generational cycle. So that such short-lived
+ * temporaries need not reach malloc, small memory blocks allocated while the garbage collector
+ * runs come from the nursery: an arena whose never-used memory is handed out by bumping a pointer.
+ * Memory blocks are never moved (C code holds raw Value pointers), so a surviving object
+ * is promoted in place, made old by the sweep. A freed memory block goes on a list of
+ * free blocks of its size (so it must be freed with the size it was allocated with, as
+ * totalbytes also requires), and the next allocation of that size reuses it.
+ * A survivor keeps its memory in the arena until it dies, so the arena can get used up.
+ * Then, when a size's list is empty, memory blocks come from malloc instead.
+ * Once every memory block allocated from the nursery has been freed, the whole arena
+ * is unused again: the bump pointer goes back to its start.
+*/
+
+/** Return true if the memory block was allocated from the nursery */
+#define nursery_has(vm, p) \
+	((uintptr_t)(p) - (uintptr_t)(vm)->nursery < (uintptr_t)AVM_NURSERYSIZE)
+/** Index into nurseryfree for a memory block of this size (1 to AVM_NURSERYMAXSZ) */
+#define nursery_sizeidx(size) (((size)-1) / AVM_NURSERYALIGN)
+
+/* Allocate the VM's nursery, with all of it unused */
+void mem_nurseryinit(VmInfo *vm) {
+	vm->nursery = (char*) mem_frealloc(NULL, AVM_NURSERYSIZE);
+	vm->nurserytop = vm->nursery;
+	vm->nurseryend = vm->nursery? vm->nursery + AVM_NURSERYSIZE : NULL;  // If not allocated, everything is malloc'ed
+	vm->nurserylive = 0;
+	for (int i = 0; i < AVM_NURSERYMAXSZ/AVM_NURSERYALIGN; i++)
+		vm->nurseryfree[i] = NULL;
+}
+
+/* Free the VM's nursery */
+void mem_nurseryclose(VmInfo *vm) {
+	if (vm->nursery)
+		mem_frealloc(vm->nursery, 0);
+	vm->nursery = NULL;
+}
+
+/** Allocate a memory block from the nursery: a freed one of the same size or else a never-used one.
+ * Return NULL if there is no room. */
+void *mem_nurseryalloc(VmInfo *vm, Auint size) {
+	void **freelist = &vm->nurseryfree[nursery_sizeidx(size)];
+	void *block = *freelist;
+	if (block)
+		*freelist = *(void**)block;
+	else {
+		size = (nursery_sizeidx(size) + 1) * AVM_NURSERYALIGN;
+		if (size > (Auint)(vm->nurseryend - vm->nurserytop))
+			return NULL;
+		block = vm->nurserytop;
+		vm->nurserytop += size;
+	}
+	vm->nurserylive++;
+	return block;
+}
+
+/** Put a memory block allocated from the nursery on the list of free blocks of its size.
+ * If it was the last one in use, start the arena over instead, with every list empty. */
+void mem_nurseryfree(VmInfo *vm, void *block, Auint size) {
+	if (--vm->nurserylive == 0) {
+		vm->nurserytop = vm->nursery;
+		for (int i = 0; i < AVM_NURSERYMAXSZ/AVM_NURSERYALIGN; i++)
+			vm->nurseryfree[i] = NULL;
+		return;
+	}
+	void **freelist = &vm->nurseryfree[nursery_sizeidx(size)];
+	*(void**)block = *freelist;
+	*freelist = block;
+}
+#endif
+
 /** Garbage-collection savvy memory malloc, free and realloc function
  * - If nsize==0, it frees the memory block (if non-NULL)
  * - If ptr==NULL, it allocates a new uninitialized memory block
@@ -25,6 +100,25 @@ void *mem_gcrealloc(Value th, void *block, Auint osize, Auint nsize) {
 	Auint realosize = (block) ? osize : 0;
 	assert((realosize == 0) == (block == NULL));
 
+#ifndef AVM_NONURSERY
+	// Small new blocks come from the nursery while the collector runs.
+	// A nursery block is resized by copying it to a new block.
+	VmInfo *vm = vm(th);
+	if (block && nursery_has(vm, block)) {
+		newblock = nsize > 0? mem_gcrealloc(th, NULL, 0, nsize) : NULL;
+		if (newblock)
+			memcpy(newblock, block, osize < nsize? osize : nsize);
+		mem_nurseryfree(vm, block, osize);
+		vm->totalbytes -= osize;
+		return newblock;
+	}
+	if (block == NULL && nsize > 0 && nsize <= AVM_NURSERYMAXSZ && vm->gcrunning
+		&& (newblock = (Value) mem_nurseryalloc(vm, nsize)) != NULL) {
+		vm->totalbytes += nsize;
+		return newblock;
+	}
+#endif
+
 	// Allocate/free/resize the memory block
 	newblock = (Value) mem_frealloc(block, nsize);
 
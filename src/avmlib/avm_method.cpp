@@ -16,6 +16,13 @@ extern "C" {
 #endif
 
 void methodRunC(Value th);
+bool float_almostequal(Afloat a, Afloat b);
+
+// Core types' Each methods, whose iteration OpEachPrep performs natively instead
+int list_each(Value th);
+int range_each(Value th);
+int index_each(Value th);
+int text_each(Value th);
 
 /* Build a new c-method value, pointing to a method written in C */
 Value newCMethod(Value th, Value *dest, AcMethodp method) {
@@ -49,7 +56,7 @@ MethodTypes returnNulls(Value th) {
 
 	// Update thread's values
 	th(th)->stk_top = to; // Mark position of last returned
-	ci = th(th)->curmethod = ci->previous; // Back up a frame
+	ci = --th(th)->curmethod; // Back up a frame
 
 	// Return to 'c' method caller, if we were called from there
 	if (!isMethod(ci->method) || isCMethod(ci->method))
@@ -85,10 +92,14 @@ MethodTypes callMorCPrep(Value th, Value *methodval, int nexpected, int flags) {
 	else
 		realmethod = *methodval; // This is the actual method
 
+	// Bytecode that has not passed verification is never run
+	if (!isCMethod(realmethod) && !(methodFlags(realmethod) & METHOD_FLG_VERIFIED))
+		return invalidCall(th, methodval, nexpected);
+
 	/* Generate yielder, if that is what this method does */
 	if (isYieldMeth(realmethod)) {
 		// Create a new yielder on top of stack
-		ThreadInfo *yielder = (ThreadInfo*) newThread(th, th(th)->stk_top, *methodval, 64, ThreadYielder);
+		ThreadInfo *yielder = (ThreadInfo*) newYielder(th, th(th)->stk_top, *methodval);
 
 		// Calculate number of parms to copy over, number of fill nulls
 		int nparms = th(th)->stk_top - methodval - 1;
@@ -130,7 +141,7 @@ MethodTypes callMorCPrep(Value th, Value *methodval, int nexpected, int flags) {
 	}
 
 	// Start and initialize a new CallInfo block
-	CallInfo * ci = th(th)->curmethod = th(th)->curmethod->next ? th(th)->curmethod->next : thrGrowCI(th);
+	CallInfo * ci = thrPushCI(th);
 	ci->nresults = nexpected;
 	ci->retTo = (ci->methodbase = methodval) + (flags>>1);  // Address of method value, varargs and return values
 	ci->begin = ci->end = methodval + 1; // Parameter values are right after method value
@@ -152,7 +163,7 @@ MethodTypes callMorCPrep(Value th, Value *methodval, int nexpected, int flags) {
 		BMethodInfo *bmethod = (BMethodInfo*) ci->method; // Capture it now before it moves
 
 		// Initialize byte-code's call info
-		ci->ip = bmethod->code; // Start with first instruction
+		ci->ip = bmethod->runcode; // Start with first instruction
 
 		// Ensure sufficient data stack space.
 		needMoreLocal(th, bmethod->maxstacksize); // methodval may no longer be reliable
@@ -183,6 +194,33 @@ MethodTypes callMorCPrep(Value th, Value *methodval, int nexpected, int flags) {
 	}
 }
 
+/* Prepare call from bytecode to a bytecode method flagged METHOD_FLG_FASTCALL.
+ * It is verified, has only fixed parameters and does not create a yielder.
+ * So, unless the stack or call frames need to grow first (left to callMorCPrep),
+ * the new frame just needs its bounds and any missing parameters set to null. */
+MethodTypes callBCFastPrep(Value th, Value *methodval, int nexpected, int flags) {
+	ThreadInfo *thr = th(th);
+	BMethodInfo *bmethod = (BMethodInfo*) *methodval;
+	if (thr->curmethod == thr->calls_last || (AuintIdx)(thr->stk_last - thr->stk_top) <= bmethod->maxstacksize + STACK_EXTRA)
+		return callMorCPrep(th, methodval, nexpected, flags);
+
+	// Initialize call frame, its end past local and temporary values (as needMoreLocal would)
+	CallInfo *ci = ++thr->curmethod;
+	ci->nresults = nexpected;
+	ci->retTo = (ci->methodbase = methodval) + (flags>>1);
+	ci->begin = methodval + 1;
+	ci->end = thr->stk_top + bmethod->maxstacksize;
+	ci->method = (Value) bmethod;
+	ci->ip = bmethod->runcode;
+
+	// If we do not have enough fixed parameters then add in nulls
+	for (Value *parm = thr->stk_top; parm < ci->begin + methodNParms(bmethod); parm++)
+		*parm = aNull;
+
+	thr->stk_top = ci->end;
+	return MethodBC;
+}
+
 /** A tailcall is effectively a call that does not increase the call stack size (a goto).
  * It replaces the current call frame state with state for the called method.
  * This function is only used at the end of a bytecode method and never from a C method.
@@ -209,6 +247,10 @@ MethodTypes tailcallMorCPrep(Value th, Value *methodval, int getset) {
 	else
 		realmethod = *methodval; // This is the actual method
 
+	// Bytecode that has not passed verification is never run
+	if (!isCMethod(realmethod) && !(methodFlags(realmethod) & METHOD_FLG_VERIFIED))
+		return returnNulls(th);
+
 	// Alter current call frame to specify method we are calling and parms
 	CallInfo * ci = th(th)->curmethod;
 	// Capture method whose code we are running, extracting from closure if needed
@@ -235,7 +277,7 @@ MethodTypes tailcallMorCPrep(Value th, Value *methodval, int getset) {
 		BMethodInfo *bmethod = (BMethodInfo*) ci->method; // Capture it now before it moves
 
 		// Initialize byte-code's call info
-		ci->ip = bmethod->code; // Start with first instruction
+		ci->ip = bmethod->runcode; // Start with first instruction
 
 		// Ensure sufficient data stack space.
 		needMoreLocal(th, bmethod->maxstacksize); // methodval may no longer be reliable
@@ -266,6 +308,54 @@ MethodTypes tailcallMorCPrep(Value th, Value *methodval, int getset) {
 	}
 }
 
+/* Prepare call to a stackless yielder value on stack (with parms above it).
+ * Its frame is resumed on this thread, much like a byte-code method call: the
+ * registers saved at its last yield are restored, with the parameters placed
+ * where that yield expects its results. Returns MethodBC. */
+MethodTypes callStacklessPrep(Value th, Value *methodval, int nexpected, int flags) {
+	ThreadInfo *yielder = (ThreadInfo*)*methodval;
+	CallInfo *ycf = yielder->curmethod;
+	BMethodInfo *bmethod = (BMethodInfo*) ycf->method;
+	AuintIdx nregs = bmethod->maxstacksize;
+	AintIdx resultpos = ycf->retTo - ycf->begin; // register for the yield's first result
+
+	// Determine number of parms to use and nulls to add, as the yield wants
+	int nparms = th(th)->stk_top - methodval - 2; // skip 'self'
+	if (nparms<0) nparms = 0;
+	int nulls = 0;
+	if (ycf->nresults != BCVARRET && (nulls = ycf->nresults - nparms) < 0) {
+		nparms = ycf->nresults;
+		nulls = 0;
+	}
+	if (nparms + nulls > (int) nregs - resultpos) {
+		nparms = nregs - resultpos;
+		nulls = 0;
+	}
+
+	// Start and initialize a new CallInfo block
+	CallInfo *ci = thrPushCI(th);
+	ci->nresults = nexpected;
+	ci->retTo = (ci->methodbase = methodval) + (flags>>1);
+	ci->begin = ci->end = methodval + 1;
+	ci->method = (Value) bmethod;
+	ci->ip = ycf->ip;
+	needMoreLocal(th, bmethod->maxstacksize); // methodval may no longer be reliable
+
+	// Move parms out of the way, restore the saved registers, then put in the parms
+	Value *regs = ci->begin;
+	memmove(regs + nregs, regs + 1, nparms*sizeof(Value));
+	memcpy(regs, ycf->begin, nregs*sizeof(Value));
+	memcpy(regs + resultpos, regs + nregs, nparms*sizeof(Value));
+	for (regs += resultpos + nparms; nulls--; regs++)
+		*regs = aNull;
+	for (regs = ci->begin + nregs; regs < ci->end; regs++)
+		*regs = aNull;
+
+	// Bytecode rarely uses stk_top; put it above local frame stack.
+	th(th)->stk_top = ci->end;
+	return MethodBC;
+}
+
 /* Prepare call to yielder value on stack (with parms above it). 
  * Specify how many return values to expect to find on stack.
  * Flags>>1 is retTo displacement
@@ -282,6 +372,9 @@ MethodTypes callYielderPrep(Value th, Value *methodval, int nexpected, int flags
 	if (yielder->flags1 & ThreadDone)
 		return invalidCall(th, methodval, nexpected);
 
+	if (yielder->flags1 & ThreadStackless)
+		return callStacklessPrep(th, methodval, nexpected, flags);
+
 	// Copy parameters over to top of yielder's stack
 	CallInfo *ycf = yielder->curmethod;
 	Value *from = methodval+2; // skip 'self'
@@ -314,6 +407,7 @@ void methodRunC(Value th) {
 
 	// Perform C method, capturing number of return values
 	AintIdx have = (((CMethodInfo*)(ci->method))->methodp)(th);
+	ci = th(th)->curmethod; // Its calls may have moved the call stack
 	
 	// Calculate how any we have to copy down and how many nulls for padding
 	Value *from = th(th)->stk_top-have;
@@ -333,81 +427,339 @@ void methodRunC(Value th) {
 
 	// Update thread's values
 	th(th)->stk_top = to; // Mark position of last returned
-	th(th)->curmethod = ci->previous; // Back up a frame
+	th(th)->curmethod = ci-1; // Back up a frame
 	return;
 }
 
+/** Get self's property value, using (and refreshing) a call site's inline property cache.
+ * The cache is keyed on self's type and the property symbol. */
+Value methGetPropCached(Value th, BMethodInfo *meth, PropCache *pc, Value self, Value sym) {
+	// A prototype looks first among its own properties. These are not cached,
+	// so that writing an instance's fields need not invalidate any cache.
+	if (isPrototype(self)) {
+		Value *valp = tblGetp(self, sym);
+		if (valp)
+			return *valp;
+	}
+	Value type = getType(th, self);
+
+	// Look for a hit, unless types have changed since the cache was filled
+	if (pc->epoch == vm(th)->typeepoch) {
+		for (AuintIdx j=0; j<pc->nbrentries; j++)
+			if (pc->entry[j].type==type && pc->entry[j].sym==sym)
+				return pc->entry[j].val;
+	}
+	else {
+		pc->epoch = vm(th)->typeepoch;
+		pc->nbrentries = 0;
+	}
+
+	// On a miss, do the full lookup and remember it (if there is still room)
+	Value val = getProperty(th, self, sym);
+	if (pc->nbrentries < AVM_PROPCACHESIZE) {
+		pc->entry[pc->nbrentries].type = type;
+		pc->entry[pc->nbrentries].sym = sym;
+		pc->entry[pc->nbrentries].val = val;
+		pc->nbrentries++;
+		mem_markChk(th, meth, type);
+		mem_markChk(th, meth, sym);
+		mem_markChk(th, meth, val);
+	}
+	return val;
+}
+
+/** Inline property cache for the call site being executed (it is in the following OpExtraArg) */
+#define vmpropcache() (&meth->propcache[bc_ax(*ci->ip++)])
+
+/** Is the frame running a stackless yielder's method (on its caller's thread)?
+ * Only a yielder thread's entry frame otherwise runs a yielder method. */
+#define isStacklessCI(th, ci) \
+	(isYieldMeth((ci)->method) && !(isYielder(th) && (ci)==thrEntryCI(th)))
+
 /** macro to make method calls consistent easier to read in methodRunBC */
 #define methCall(firstreg, nexpected, flags) \
-	switch (canCallMorC(*firstreg)? callMorCPrep(th, firstreg, nexpected, flags) \
-		: isYielder(*firstreg)? callYielderPrep(th, firstreg, nexpected, flags) \
-		: invalidCall(th, firstreg, nexpected)) { \
+	switch (isMethod(*(firstreg)) && (methodFlags(*(firstreg)) & METHOD_FLG_FASTCALL)? callBCFastPrep(th, (firstreg), nexpected, flags) \
+		: canCallMorC(*(firstreg))? callMorCPrep(th, (firstreg), nexpected, flags) \
+		: isYielder(*(firstreg))? callYielderPrep(th, (firstreg), nexpected, flags) \
+		: invalidCall(th, (firstreg), nexpected)) { \
 	case MethodY: \
-		th = *rega; \
+		th = *(firstreg); \
 	case MethodBC: \
 		ci = th(th)->curmethod; \
 		meth = (BMethodInfo*) (ci->method); \
 		lits = meth->lits; \
 		stkbeg = ci->begin; \
+		if (ci->ip == meth->runcode) \
+			vmjit(); \
+		break; \
+	default: \
+		ci = th(th)->curmethod; /* Call stack may have moved */ \
 	}
 
-/* Execute byte-code method pointed at by thread's current call frame */
+#ifdef AVM_JIT
+/** Count a method start or loop back-edge toward translating the method to native code.
+ * Once translated (and while the JIT is on), run native code until it returns
+ * the instruction the interpreter must perform next. */
+#define vmjit() \
+	do { \
+		if (meth->jit) { \
+			if (meth->jit->native && vm(th)->jitthreshold) \
+				ci->ip = jitRun(th, meth, stkbeg, ci->ip); \
+		} \
+		else if (vm(th)->jitthreshold && ++meth->jithits >= vm(th)->jitthreshold) \
+			meth->jit = jitCompile(th, meth); \
+	} while (0)
+#else
+#define vmjit()
+#endif
+
+/** Fetch next instruction and its A register, advancing ip */
+#define vmfetch() \
+	i = *(ci->ip++); \
+	rega = stkbeg + bc_a(i); \
+	assert(stkbeg == ci->begin); \
+	assert(stkbeg <= ((ThreadInfo*)th)->stk_top && ((ThreadInfo*)th)->stk_top < ((ThreadInfo*)th)->stack + ((ThreadInfo*)th)->size)
+
+#ifdef AVM_COMPUTEDGOTO
+/* Direct-threaded dispatch: every instruction ends by jumping straight to the next one's logic */
+#define vmdispatch(op) goto *disptab[op];
+#define vmcase(op) L_##op:
+#define vmbreak {vmfetch(); vmdispatch(bc_op(i));}
+#else
+/* Portable dispatch: a switch inside the interpreter's main loop */
+#define vmdispatch(op) switch (op)
+#define vmcase(op) case op:
+#define vmbreak break
+#endif
+
+/** Rewrite the instruction just fetched (in runcode) to another form of the same operation */
+#define vmquicken(op) (*(ci->ip-1) = (i & ~(Instruction)0xff) | (op))
+
+/** Arithmetic operator: R(A) := R(B) op R(C).
+ * Integer and Float pairs are done inline, quickening the instruction to
+ * the op for that type. Otherwise operator's method is called on R(B) */
+#define vmarith(sym, intquick, intop, fltquick, fltop) { \
+	Value b = *(stkbeg + bc_b(i)); \
+	Value c = *(stkbeg + bc_c(i)); \
+	if (isInt(b) && isInt(c) && vm(th)->fastnumops) { \
+		vmquicken(intquick); \
+		intop; \
+	} \
+	else if (isFloat(b) && isFloat(c) && vm(th)->fastnumops) { \
+		vmquicken(fltquick); \
+		fltop; \
+	} \
+	else { \
+		*rega = getProperty(th, b, vmlit(sym)); \
+		*(rega+1) = b; \
+		*(rega+2) = c; \
+		th(th)->stk_top = rega+3; \
+		methCall(rega, 1, 0); \
+	} \
+}
+
+/** Quickened arithmetic operator, whose operands are expected to pass test.
+ * If not, it goes back to its generic op and does that instead. */
+#define vmquickarith(test, generic, op) { \
+	Value b = *(stkbeg + bc_b(i)); \
+	Value c = *(stkbeg + bc_c(i)); \
+	if (test(b) && test(c) && vm(th)->fastnumops) \
+		op; \
+	else { \
+		vmquicken(generic); \
+		ci->ip--; \
+	} \
+}
+
+/** Inline forms of each arithmetic operator on Value b and c */
+#define vmAddInt (*rega = anInt(toAint(b) + toAint(c)))
+#define vmAddFloat (*rega = aFloat(toAfloat(b) + toAfloat(c)))
+#define vmSubInt (*rega = anInt(toAint(b) - toAint(c)))
+#define vmSubFloat (*rega = aFloat(toAfloat(b) - toAfloat(c)))
+#define vmMulInt (*rega = anInt(toAint(b) * toAint(c)))
+#define vmMulFloat (*rega = aFloat(toAfloat(b) * toAfloat(c)))
+#define vmDivInt (*rega = c==anInt(0)? aNull : anInt(toAint(b) / toAint(c)))
+#define vmDivFloat (*rega = aFloat(toAfloat(b) / toAfloat(c)))
+#define vmRocketInt (x==y? 0 : toAint(x)<toAint(y)? -1 : 1)
+#define vmRocketFloat (float_almostequal(toAfloat(x), toAfloat(y))? 0 : toAfloat(x)<toAfloat(y)? -1 : 1)
+
+/** Finish OpRocket with its result cmp (-1, 0 or 1):
+ * perform the conditional jump on R(A) that follows, or else store it in R(A) */
+#define vmrocketresult(cmp) { \
+	Instruction j = *ci->ip; \
+	if (bc_op(j)>=OpJEq && bc_op(j)<=OpJGeN && bc_a(j)==bc_a(i)) { \
+		ci->ip++; \
+		if (rocketJumps[bc_op(j)-OpJEq] & (1<<((cmp)+1))) \
+			ci->ip += bc_j(j); \
+	} \
+	else \
+		*rega = anInt(cmp); \
+}
+
+/** For each conditional jump on a <=> result (OpJEq .. OpJGeN), which results jump: 
+ * bit 0 for -1, bit 1 for 0, bit 2 for 1 */
+static const unsigned char rocketJumps[] = {2, 5, 1, 3, 4, 6, 2, 5, 1, 3, 4, 6};
+
+/** How an each loop iterates, as set in R(A) by OpEachPrep or OpForPrep. From EachList
+ * to EachText, OpEachCall quickens to the op at the same distance from OpEachList. */
+enum EachKinds {
+	EachClosure,	//!< Call the iterator closure in R(A+3)
+	EachList,		//!< R(A+1) is next index into List R(A+3)
+	EachRange,		//!< R(A+1) is next Integer/Float, R(A+2) its limit, R(A+3) its step
+	EachIndex,		//!< R(A+1) is next node position in Index R(A+3)
+	EachText,		//!< R(A+1) is next byte position in Text R(A+3), R(A+2) its char index
+	ForInt,			//!< R(A+1) is current Integer, R(A+2) its limit, R(A+3) its step
+	ForFloat,		//!< R(A+1) is current Float, R(A+2) its limit, R(A+3) its step
+	ForCalled,		//!< OpForLoop has just called the iterator closure in R(A+3)
+};
+
+/** If 'each' is coll's built-in Each method for a List, Range, Index or Text,
+ * set up an each loop's registers from reg to iterate over coll natively
+ * (see EachKinds). Return false if it needs the closure Each returns instead. */
+bool eachPrepNative(Value th, Value *reg, Value coll, Value each) {
+	if (!isMethod(each) || !isCMethod(each))
+		return false;
+	AcMethodp methodp = ((CMethodInfo*)each)->methodp;
+	if (methodp == list_each && isArr(coll)) {
+		reg[0] = anInt(EachList);
+		reg[1] = anInt(0);
+	}
+	else if (methodp == range_each && isArr(coll) && arr_size(coll) >= 3) {
+		Value from = arrGet(th, coll, 0);
+		Value to = arrGet(th, coll, 1);
+		Value step = arrGet(th, coll, 2);
+		if (!(isInt(from) && isInt(to) && isInt(step))
+			&& !(isFloat(from) && isFloat(to) && isFloat(step)))
+			return false;
+		reg[0] = anInt(EachRange);
+		reg[1] = from;
+		reg[2] = to;
+		reg[3] = step;
+		return true;
+	}
+	else if (methodp == index_each && isTbl(coll)) {
+		reg[0] = anInt(EachIndex);
+		reg[1] = anInt(0);
+	}
+	else if (methodp == text_each && isStr(coll)) {
+		reg[0] = anInt(EachText);
+		reg[1] = anInt(0);
+		reg[2] = anInt(0);
+	}
+	else
+		return false;
+	reg[3] = coll;
+	return true;
+}
+
+/** Is the Range type's Each still its built-in one, which OpForLoop may do inline? */
+bool forRangeNative(Value th) {
+	Value *each = tblGetp(vmlit(TypeRangem), vmlit(SymEachMeth));
+	return each && isMethod(*each) && isCMethod(*each) && ((CMethodInfo*)*each)->methodp == range_each;
+}
+
+/** Natively iterating OpEachCall or OpForLoop: R(A) must still be the kind it was quickened for.
+ * If not, it goes back to its generic op, which works out how to iterate instead. */
+#define vmeachguard(kind, generic) \
+	if (*rega != anInt(kind)) { \
+		vmquicken(generic); \
+		ci->ip--; \
+		vmbreak; \
+	}
+
+/** Has a Range stepping by step gone past its end value to? */
+#define vmrangedone(step, cur, to) (((step)>=0 && (cur)>(to)) || ((step)<0 && (cur)<(to)))
+
+/** Natively iterating OpEachCall: load the loop's C values (key, val, then nulls) into R(A+4)... */
+#define vmeachresults(key, val) { \
+	int nvals = bc_c(i); \
+	*(rega+4) = (key); \
+	if (nvals > 1) \
+		*(rega+5) = (val); \
+	for (int j = 2; j < nvals; j++) \
+		*(rega+4+j) = aNull; \
+}
+
+/* Execute byte-code method pointed at by thread's current call frame.
+ * Its operands are trusted without checks, as methodVerify has proven them. */
 void methodRunBC(Value th) {
 	CallInfo *ci = ((ThreadInfo*)th)->curmethod;
 	BMethodInfo* meth = (BMethodInfo*) (ci->method);
 	Value *lits = meth->lits; 
 	Value *stkbeg = ci->begin;
+	assert(methodFlags(meth) & METHOD_FLG_VERIFIED);
+
+	Instruction i;
+	Value *rega;
+#ifdef AVM_COMPUTEDGOTO
+	// Label addresses for each instruction's logic, in exact ByteCodeOps order
+	static void *disptab[] = {
+		&&L_OpLoadReg, &&L_OpLoadRegs, &&L_OpLoadLit, &&L_OpLoadLitx, &&L_OpExtraArg,
+		&&L_OpLoadPrim, &&L_OpLoadNulls, &&L_OpLoadContext, &&L_OpLoadVararg, &&L_OpGetGlobal,
+		&&L_OpSetGlobal, &&L_OpGetClosure, &&L_OpSetClosure, &&L_OpNewClosure, &&L_OpJump,
+		&&L_OpJNull, &&L_OpJNNull, &&L_OpJTrue, &&L_OpJFalse, &&L_OpJEq, &&L_OpJNe, &&L_OpJLt, &&L_OpJLe,
+		&&L_OpJGt, &&L_OpJGe, &&L_OpJEqN, &&L_OpJNeN, &&L_OpJLtN, &&L_OpJLeN, &&L_OpJGtN,
+		&&L_OpJGeN, &&L_OpJSame, &&L_OpJDiff, &&L_OpLoadStd, &&L_OpGetMeth, &&L_OpGetProp,
+		&&L_OpSetProp, &&L_OpGetActProp, &&L_OpSetActProp, &&L_OpGetCall, &&L_OpSetCall,
+		&&L_OpReturn, &&L_OpYield, &&L_OpTailCall, &&L_OpEachPrep, &&L_OpEachSplat,
+		&&L_OpEachCall, &&L_OpForPrep, &&L_OpForLoop, &&L_OpSwitch, &&L_OpAdd, &&L_OpSub,
+		&&L_OpMul, &&L_OpDiv, &&L_OpRocket, &&L_OpLoadLitReg, &&L_OpAddInt, &&L_OpAddFloat,
+		&&L_OpSubInt, &&L_OpSubFloat, &&L_OpMulInt, &&L_OpMulFloat, &&L_OpDivInt,
+		&&L_OpDivFloat, &&L_OpRocketInt, &&L_OpRocketFloat, &&L_OpEachList, &&L_OpEachRange,
+		&&L_OpEachIndex, &&L_OpEachText, &&L_OpForLoopInt, &&L_OpForLoopFloat
+	};
+#endif
+
+	// A method just starting may run natively
+	if (ci->ip == meth->runcode)
+		vmjit();
 
 	// main loop of interpreter
 	for (;;) {
-		Instruction i = *(ci->ip++);
-		Value *rega = stkbeg + bc_a(i);
-		assert(stkbeg == ci->begin);
-		assert(stkbeg <= ((ThreadInfo*)th)->stk_top && ((ThreadInfo*)th)->stk_top < ((ThreadInfo*)th)->stack + ((ThreadInfo*)th)->size);
-		switch (bc_op(i)) {
+		vmfetch();
+		vmdispatch(bc_op(i)) {
 
 		// OpLoadReg: R(A) := R(B)
-		case OpLoadReg:
+		vmcase(OpLoadReg)
 			*rega = *(stkbeg + bc_b(i));
-			break;
+			vmbreak;
 
 		// OpLoadRegs: R(A .. A+C-1) := R(B .. B+C-1)
-		case OpLoadRegs: 
+		vmcase(OpLoadRegs) 
 			memmove(rega, stkbeg+bc_b(i), bc_c(i)*sizeof(Value));
-			break;
+			vmbreak;
 
 		// OpLoadLit: R(A) := Literals(D)
-		case OpLoadLit:
+		vmcase(OpLoadLit)
 			*rega = *(lits + bc_bx(i));
-			break;
+			vmbreak;
 
 		// OpLoadLitX: R(A) := Literals(extra arg) {+ EXTRAARG(Ax)}
-		case OpLoadLitx:
-			assert(bc_op(*ci->ip) == OpExtraArg);
-			*rega = *(lits + bc_ax(i));
-			break;
+		vmcase(OpLoadLitx)
+			*rega = *(lits + bc_ax(*ci->ip++));
+			vmbreak;
 
 		// OpLoadPrim: R(A) := B==0? null, B==1? false, B==2? true
-		case OpLoadPrim:
+		vmcase(OpLoadPrim)
 			*rega = (Value)((((Auint)bc_b(i)) << ValShift) + ValCons);
-			break;
+			vmbreak;
 
 		// OpLoadNulls: R(A), R(A+1), ..., R(A+B) := null
-		case OpLoadNulls:
+		vmcase(OpLoadNulls)
 			{BCReg b = bc_b(i);
 			do {
 				*rega++ = aNull;
 			} while (b--);}
-			break;
+			vmbreak;
 
 		// OpLoadContext: R(A) := B==0? th, B==1? ci->methodbase
-		case OpLoadContext:
+		vmcase(OpLoadContext)
 			*rega = bc_b(i)==0? th : *(ci->methodbase);
-			break;
+			vmbreak;
 
 		// OpLoadVararg: R(A), R(A+1), ..., R(A+B-1) := vararg
 		// if (B == 0xFF), use actual number of varargs and set top
-		case OpLoadVararg: {
+		vmcase(OpLoadVararg) {
 			AuintIdx nbrvar = stkbeg - ci->methodbase - methodNParms(meth) - 1;
 			AuintIdx cnt = bc_b(i);
 			if (cnt==BCVARRET) {
@@ -418,131 +770,159 @@ void methodRunBC(Value th) {
 			}
 			for (AuintIdx j = 0; j < cnt; j++)
 				*rega++ = (j < nbrvar)? *(stkbeg+j-nbrvar) : aNull;
-			} break;
-
-		// OpGetGlobal: R(A) := Globals(Literals(D))
-		case OpGetGlobal:
-			*rega = gloGet(th, *(lits + bc_bx(i)));
-			break;
-
-		// OpSetGlobal: Globals(Literals(D)) := R(A)
-		case OpSetGlobal:
-			gloSet(th, *(lits + bc_bx(i)), *rega);
-			break;
+			} vmbreak;
+
+		// OpGetGlobal: R(A) := Globals(Literals(D)), literal being the global's bound cell
+		vmcase(OpGetGlobal)
+			*rega = arr_info(*(lits + bc_bx(i)))->arr[0];
+			vmbreak;
+
+		// OpSetGlobal: Globals(Literals(D)) := R(A), literal being the global's bound cell
+		vmcase(OpSetGlobal)
+			gloSet(th, arr_info(*(lits + bc_bx(i)))->arr[1], *rega);
+			vmbreak;
+
+		// OpGetClosure: R(A) := Closure(B), reading the running closure's slot in place
+		vmcase(OpGetClosure) {
+			Value clo = *ci->methodbase;
+			*rega = (isEnc(clo, ArrEnc) && bc_b(i) < arr_size(clo))? arr_info(clo)->arr[bc_b(i)] : aNull;
+			vmbreak;
+		}
 
-		// OpGetClosure: R(A) := Closure(D)
-		case OpGetClosure:
-			if (isArr(*ci->methodbase))
-				*rega = arrGet(th, *ci->methodbase, bc_b(i));
-			break;
+		// OpSetClosure: Closure(B) := R(A), writing the running closure's slot in place
+		vmcase(OpSetClosure) {
+			Value clo = *ci->methodbase;
+			if (isEnc(clo, ArrEnc) && bc_b(i) < arr_size(clo)) {
+				arr_info(clo)->arr[bc_b(i)] = *rega;
+				if (isPtr(*rega) && isblack((MemInfo*)clo))
+					mem_markChk(th, clo, *rega);
+			}
+			vmbreak;
+		}
 
-		// OpSetClosure: Closure(D) := R(A)
-		case OpSetClosure:
-			if (isArr(*ci->methodbase))
-				arrSet(th, *ci->methodbase, bc_b(i), *rega);
-			break;
+		// OpNewClosure: R(A) := new Closure(R(A) .. R(A+B-1))
+		// R(A) is the get method, R(A+1) the set method and the rest its closure variables
+		vmcase(OpNewClosure) {
+			Value clo;
+			newClosure(th, &clo, vmlit(TypeClom), bc_b(i));
+			memcpy(arr_info(clo)->arr, rega, bc_b(i)*sizeof(Value));
+			arr_info(clo)->size = bc_b(i);
+			*rega = clo;
+			vmbreak;
+		}
 
-		// OpJump: ip += sBx
-		case OpJump:
+		// OpJump: ip += sBx. A jump back (a loop) may continue natively.
+		vmcase(OpJump)
 			ci->ip += bc_j(i);
-			break;
+			if (bc_j(i) < 0)
+				vmjit();
+			vmbreak;
 
 		// OpJNull: if R(A)===null then ip += sBx
-		case OpJNull:
-			if (*rega==aNull) ci->ip += bc_j(i); break;
+		vmcase(OpJNull)
+			if (*rega==aNull) ci->ip += bc_j(i); vmbreak;
 
 		// OpJTrue: if R(A)!==null then ip += sBx
-		case OpJNNull:
-			if (*rega!=aNull) ci->ip += bc_j(i); break;
+		vmcase(OpJNNull)
+			if (*rega!=aNull) ci->ip += bc_j(i); vmbreak;
 
 		// OpJTrue: if R(A) then ip += sBx
-		case OpJTrue:
-			if (!isFalse(*rega)) ci->ip += bc_j(i); break;
+		vmcase(OpJTrue)
+			if (!isFalse(*rega)) ci->ip += bc_j(i); vmbreak;
 
 		// OpJFalse: if !R(A) then ip += sBx
-		case OpJFalse:
-			if (isFalse(*rega)) ci->ip += bc_j(i); break;
+		vmcase(OpJFalse)
+			if (isFalse(*rega)) ci->ip += bc_j(i); vmbreak;
 
 		// OpJSame: if R(A)===R(A+1) then ip += sBx.
-		case OpJSame:
-			if (isSame(*rega, *(rega+1))) ci->ip += bc_j(i); break;
+		vmcase(OpJSame)
+			if (isSame(*rega, *(rega+1))) ci->ip += bc_j(i); vmbreak;
 
 		// OpJDiff: if R(A)!===R(A+1) then ip += sBx
-		case OpJDiff:
-			if (!isSame(*rega, *(rega+1))) ci->ip += bc_j(i); break;
+		vmcase(OpJDiff)
+			if (!isSame(*rega, *(rega+1))) ci->ip += bc_j(i); vmbreak;
 
 		// OpJEq: if R(A)==0 then ip+= sBx.
-		case OpJEq:
-			if (*rega == anInt(0)) ci->ip += bc_j(i); break;
+		vmcase(OpJEq)
+			if (*rega == anInt(0)) ci->ip += bc_j(i); vmbreak;
 
 		// OpJEqN: if R(A)==0 or null then ip+= sBx.
-		case OpJEqN:
-			if (*rega == anInt(0) || *rega == aNull) ci->ip += bc_j(i); break;
+		vmcase(OpJEqN)
+			if (*rega == anInt(0) || *rega == aNull) ci->ip += bc_j(i); vmbreak;
 
 		// OpJNe: if R(A)!=0 or not Integer then ip+= sBx.
-		case OpJNe:
-			if (*rega != anInt(0)) ci->ip += bc_j(i); break;
+		vmcase(OpJNe)
+			if (*rega != anInt(0)) ci->ip += bc_j(i); vmbreak;
 
 		// OpJNeN: if R(A)!=0 or not Integer then ip+= sBx.
-		case OpJNeN:
-			if (*rega != anInt(0) || *rega == aNull) ci->ip += bc_j(i); break;
+		vmcase(OpJNeN)
+			if (*rega != anInt(0) || *rega == aNull) ci->ip += bc_j(i); vmbreak;
 
 		// OpJLt: if R(A)<0 then ip+= sBx.
-		case OpJLt:
-			if (isInt(*rega) && toAint(*rega) < 0) ci->ip += bc_j(i); break;
+		vmcase(OpJLt)
+			if (isInt(*rega) && toAint(*rega) < 0) ci->ip += bc_j(i); vmbreak;
 
 		// OpJLtN: if R(A)<0 or null then ip+= sBx.
-		case OpJLtN:
-			if (!isInt(*rega) || toAint(*rega) < 0) ci->ip += bc_j(i); break;
+		vmcase(OpJLtN)
+			if (!isInt(*rega) || toAint(*rega) < 0) ci->ip += bc_j(i); vmbreak;
 
 		// OpJLe: if R(A)<=0 then ip+= sBx.
-		case OpJLe:
-			if (isInt(*rega) && toAint(*rega) <= 0) ci->ip += bc_j(i); break;
+		vmcase(OpJLe)
+			if (isInt(*rega) && toAint(*rega) <= 0) ci->ip += bc_j(i); vmbreak;
 
 		// OpJLeN: if R(A)<=0 or null then ip+= sBx.
-		case OpJLeN:
-			if (!isInt(*rega) || toAint(*rega) <= 0) ci->ip += bc_j(i); break;
+		vmcase(OpJLeN)
+			if (!isInt(*rega) || toAint(*rega) <= 0) ci->ip += bc_j(i); vmbreak;
 
 		// OpJGt: if R(A)>0 then ip+= sBx.
-		case OpJGt:
-			if (isInt(*rega) && toAint(*rega) > 0) ci->ip += bc_j(i); break;
+		vmcase(OpJGt)
+			if (isInt(*rega) && toAint(*rega) > 0) ci->ip += bc_j(i); vmbreak;
 
 		// OpJGtN: if R(A)>0 or null then ip+= sBx.
-		case OpJGtN:
-			if (!isInt(*rega) || toAint(*rega) > 0) ci->ip += bc_j(i); break;
+		vmcase(OpJGtN)
+			if (!isInt(*rega) || toAint(*rega) > 0) ci->ip += bc_j(i); vmbreak;
 
 		// OpJGe: if R(A)>=0 then ip+= sBx.
-		case OpJGe:
-			if (isInt(*rega) && toAint(*rega) >= 0) ci->ip += bc_j(i); break;
+		vmcase(OpJGe)
+			if (isInt(*rega) && toAint(*rega) >= 0) ci->ip += bc_j(i); vmbreak;
 
 		// OpJGeN: if R(A)>=0 or null then ip+= sBx.
-		case OpJGeN:
-			if (!isInt(*rega) || toAint(*rega) >= 0) ci->ip += bc_j(i); break;
+		vmcase(OpJGeN)
+			if (!isInt(*rega) || toAint(*rega) >= 0) ci->ip += bc_j(i); vmbreak;
 
 		// LoadStd: R(A+1) := R(B); R(A) = StdMeth(C)
-		case OpLoadStd:
+		vmcase(OpLoadStd)
 			*(rega+1) = *(stkbeg + bc_b(i));
 			*rega = vmStdSym(th, bc_c(i));
-			break;
-
-		// OpEachPrep: R(A) := R(B).Each
-		case OpEachPrep:
-			*rega = *(stkbeg + bc_b(i));
-			if (isMethod(*rega)) {
-				*(rega+1) = *(ci->begin); // self
-				th(th)->stk_top = rega+2;
-				methCall(rega, 1, 1);
+			vmbreak;
+
+		// OpEachPrep: R(A+3) := R(B).Each, R(A) := EachClosure
+		// A List, Range, Index or Text using its built-in Each is instead set up
+		// for OpEachCall to iterate natively (see EachKinds)
+		vmcase(OpEachPrep) {
+			Value coll = *(stkbeg + bc_b(i));
+			*rega = anInt(EachClosure);
+			if (isMethod(coll)) {
+				*(rega+3) = coll;
+				*(rega+4) = *(ci->begin); // self
+				th(th)->stk_top = rega+5;
+				methCall(rega+3, 1, 1);
 			}
-			else if (!canCall(*rega)) {
-				*(rega+1) = *rega;
-				*rega = getProperty(th, *rega, vmlit(SymEachMeth));
-				th(th)->stk_top = rega+2;
-				methCall(rega, 1, 1);
+			else if (!canCall(coll)) {
+				Value each = getProperty(th, coll, vmlit(SymEachMeth));
+				if (!eachPrepNative(th, rega, coll, each)) {
+					*(rega+3) = each;
+					*(rega+4) = coll;
+					th(th)->stk_top = rega+5;
+					methCall(rega+3, 1, 1);
+				}
 			}
-			break;
+			else
+				*(rega+3) = coll;
+			} vmbreak;
 
 		// OpEachSplat: R(A+1) := R(A)/null, R(A+2) := ...[R(A)], R(A):=R(A)+1
-		case OpEachSplat: {
+		vmcase(OpEachSplat) {
 			AuintIdx nbrvar = stkbeg - ci->methodbase - methodNParms(meth) - 1;
 			AuintIdx j = toAint(*rega);
 			if (j<nbrvar) {
@@ -554,42 +934,42 @@ void methodRunBC(Value th) {
 				*(rega+1) = aNull;
 				*(rega+2) = aNull;
 			}
-			} break;
+			} vmbreak;
 
 		// OpGetMeth: R(A) := R(A).*R(A+1)
 		// Get property's method value (unless property is an executable method)
-		case OpGetMeth:
+		vmcase(OpGetMeth)
 			if (!canCall(*rega))
 				*rega = getProperty(th, *(rega+1), *rega); // Find executable
-			break;
+			vmbreak;
 
-		// OpGetProp: R(A) := R(A).*R(A+1)
+		// OpGetProp: R(A) := R(A).*R(A+1) {+ EXTRAARG(property cache)}
 		// Get property value
-		case OpGetProp:
-			*rega = getProperty(th, *(rega+1), *rega); // Find executable
-			break;
+		vmcase(OpGetProp)
+			*rega = methGetPropCached(th, meth, vmpropcache(), *(rega+1), *rega);
+			vmbreak;
 
 		// OpSetProp: R(A) := R(A).*R(A+1)=R(A+2)
 		// Set self's member value, if this is a table or type
-		case OpSetProp:
+		vmcase(OpSetProp)
 			if (isTbl(*(rega+1)))
 				tblSet(th, *(rega+1), *rega, *(rega+2));
 			*rega = *(rega+2);
-			break;
+			vmbreak;
 
-		// OpGetActProp: R(A .. A+C-1) := R(A).R(A+1)
+		// OpGetActProp: R(A .. A+C-1) := R(A).R(A+1) {+ EXTRAARG(property cache)}
 		// Get active property value
-		case OpGetActProp: {
-			*rega = getProperty(th, *(rega+1), *rega);
+		vmcase(OpGetActProp) {
+			*rega = methGetPropCached(th, meth, vmpropcache(), *(rega+1), *rega);
 			if (canCall(*rega)) {
 				th(th)->stk_top = rega+2; // Set fixed top for 2 values
 				methCall(rega, bc_c(i), 0);
 			}
-			} break;
+			} vmbreak;
 
 		// OpSetActProp: R(A) := R(A).R(A+1)=R(A+2)
 		// Set active property value
-		case OpSetActProp: {
+		vmcase(OpSetActProp) {
 			Value propval = getProperty(th, *(rega+1), *rega);
 			if (canCall(propval)) {
 				*rega = propval;
@@ -601,34 +981,121 @@ void methodRunBC(Value th) {
 					tblSet(th, *(rega+1), *rega, *(rega+2));
 				*rega = *(rega+2);
 			}
-			} break;
+			} vmbreak;
 
-		// OpEachCall: R(A .. A+C-1) := R(A+1).R(A)(R(A+1) .. A+B-1))
+		// OpEachCall: R(A+4 .. A+C+3) := R(A+3)(R(A+4) .. A+B+2))
 		// if (B == 0xFF) then B = top. If (C == 0xFF), then top is set to last_result+1, 
 		// so next open instruction (CALL, RETURN, VAR) may use top.
-		case OpEachCall: {
+		// If OpEachPrep set up native iteration, quicken to the op for its kind instead
+		vmcase(OpEachCall) {
+			if (*rega != anInt(EachClosure)) {
+				vmquicken(OpEachList + toAint(*rega) - EachList);
+				ci->ip--;
+			}
 			// Get property value. If executable, we can do call
-			if (canCall(*rega)) {
+			else if (canCall(*(rega+3))) {
 				// Reset frame top for fixed parms (var already has it adjusted)
 				int b = bc_b(i); // nbr of parms
 				if (b != BCVARRET) 
-					th(th)->stk_top = rega+b+1;
+					th(th)->stk_top = rega+3+b+1;
 
 				// Prepare call frame and stack, then perform the call
-				methCall(rega, bc_c(i), 2);
+				methCall(rega+3, bc_c(i), 2);
 			}
 			else {
-				*(rega+1) = aNull;
+				*(rega+4) = aNull;
 			}
-			} break;
+			} vmbreak;
+
+		// OpForPrep: Start an each loop over literal Range R(A+1) .. R(A+2) .. R(A+3),
+		// whose OpForLoop is at ip+sBx. Integer or Float ranges are stepped through
+		// inline: R(A+4), R(A+5) := true, R(A+1), or skip past OpForLoop if empty.
+		// Otherwise, R(A+3) := Range.Each, and OpForLoop calls it for the first values.
+		vmcase(OpForPrep) {
+			Value from = *(rega+1);
+			Value to = *(rega+2);
+			if (*(rega+3) == aNull)
+				*(rega+3) = isInt(from)? anInt(1) : isFloat(from)? aFloat(1.0) : aNull;
+			Value step = *(rega+3);
+			if (isInt(from) && isInt(to) && isInt(step) && forRangeNative(th)) {
+				*rega = anInt(ForInt);
+				Aint fromi = toAint(from);
+				Aint toi = toAint(to);
+				if (vmrangedone(toAint(step), fromi, toi))
+					ci->ip += bc_j(i) + 1;
+				else {
+					*(rega+4) = aTrue;
+					*(rega+5) = from;
+				}
+			}
+			else if (isFloat(from) && isFloat(to) && isFloat(step) && forRangeNative(th)) {
+				*rega = anInt(ForFloat);
+				Afloat fromf = toAfloat(from);
+				Afloat tof = toAfloat(to);
+				if (vmrangedone(toAfloat(step), fromf, tof))
+					ci->ip += bc_j(i) + 1;
+				else {
+					*(rega+4) = aTrue;
+					*(rega+5) = from;
+				}
+			}
+			else {
+				*rega = anInt(EachClosure);
+				newArr(th, rega+4, vmlit(TypeRangem), 3);
+				arrSet(th, *(rega+4), 0, from);
+				arrSet(th, *(rega+4), 1, to);
+				arrSet(th, *(rega+4), 2, step);
+				*(rega+3) = getProperty(th, *(rega+4), vmlit(SymEachMeth));
+				th(th)->stk_top = rega+5;
+				ci->ip += bc_j(i);
+				methCall(rega+3, 1, 1);
+			}
+			} vmbreak;
+
+		// OpForLoop: R(A+4), R(A+5) := R(A+3)(), then ip += sBx if R(A+4) is not false.
+		// When OpForPrep set up an Integer or Float range, quicken to step it inline instead.
+		vmcase(OpForLoop)
+			if (*rega == anInt(ForInt) || *rega == anInt(ForFloat)) {
+				vmquicken(*rega == anInt(ForInt)? OpForLoopInt : OpForLoopFloat);
+				ci->ip--;
+			}
+			// The closure's values are in: loop again, unless they are done
+			else if (*rega == anInt(ForCalled)) {
+				*rega = anInt(EachClosure);
+				if (!isFalse(*(rega+4))) {
+					ci->ip += bc_j(i);
+					vmjit();
+				}
+			}
+			// Call the closure, coming back here to check what it returns
+			else if (canCall(*(rega+3))) {
+				*rega = anInt(ForCalled);
+				ci->ip--;
+				th(th)->stk_top = rega+4;
+				methCall(rega+3, 2, 2);
+			}
+			vmbreak;
+
+		// OpSwitch: ip := Literals(Ax)[R(A)] if found there, else ip += sBx {+ EXTRAARG(Ax)}
+		// Only Integers, Symbols, true and false are looked up in the Index: any
+		// other value goes on past EXTRAARG, to match each pattern in turn.
+		vmcase(OpSwitch)
+			if (isInt(*rega) || isSym(*rega) || *rega==aTrue || *rega==aFalse) {
+				Value *dest = tblGetp(lits[bc_ax(*ci->ip)], *rega);
+				ci->ip = dest? meth->runcode + toAint(*dest) : ci->ip + bc_j(i);
+			}
+			else
+				ci->ip++;
+			vmbreak;
 
-		// OpGetCall: R(A .. A+C-1) := R(A+1).R(A)(R(A+1) .. A+B-1))
+		// OpGetCall: R(A .. A+C-1) := R(A+1).R(A)(R(A+1) .. A+B-1)) {+ EXTRAARG(property cache)}
 		// if (B == 0xFF) then B = top. If (C == 0xFF), then top is set to last_result+1, 
 		// so next open instruction (CALL, RETURN, VAR) may use top.
-		case OpGetCall: {
+		vmcase(OpGetCall) {
 			// Get property value. If executable, we can do call
+			PropCache *pc = vmpropcache();
 			if (!canCall(*rega))
-				*rega = getProperty(th, *(rega+1), *rega); // Find executable
+				*rega = methGetPropCached(th, meth, pc, *(rega+1), *rega); // Find executable
 
 			// Reset frame top for fixed parms (var already has it adjusted)
 			int b = bc_b(i); // nbr of parms
@@ -637,12 +1104,12 @@ void methodRunBC(Value th) {
 
 			// Prepare call frame and stack, then perform the call
 			methCall(rega, bc_c(i), 0);
-			} break;
+			} vmbreak;
 
 		// OpSetCall: R(A .. A+C-1) := R(A+1).R(A)(R(A+1) .. A+B-1))
 		// if (B == 0xFF) then B = top. If (C == 0xFF), then top is set to last_result+1, 
 		// so next open instruction (CALL, RETURN, VAR) may use top.
-		case OpSetCall: {
+		vmcase(OpSetCall) {
 			// Get property value. If executable, we can do call
 			if (!canCall(*rega))
 				*rega = getProperty(th, *(rega+1), *rega); // Find executable
@@ -661,21 +1128,30 @@ void methodRunBC(Value th) {
 				meth = (BMethodInfo*) (ci->method);
 				lits = meth->lits;
 				stkbeg = ci->begin;
+				break;
+			default:
+				ci = th(th)->curmethod; // Call stack may have moved
 			}
-			} break;
+			} vmbreak;
 
 		// OpTailCall: R(A .. A+C-1) := R(A+1).R(A)(R(A+1) .. A+B-1))
 		// if (B == 0xFF) then B = top. C was set by who called us.
-		case OpTailCall: {
+		vmcase(OpTailCall) {
 			int b = bc_b(i); // nbr of parms
 			// Reset frame top for fixed parms (var already has it adjusted)
 			if (b != BCVARRET) 
 				th(th)->stk_top = rega+b+1;
 
-			// Cannot do a tailcall if the return would switch threads
+			// Cannot do a tailcall if the return would switch threads or finish a yielder,
+			// nor into a yielder (which may resume its frame in ours).
 			// In this situation, we must do a normal call then a return afterwards
-			if ((isYielder(th) && ci==&th(th)->entrymethod) || (isMethod(*rega) && isYieldMeth(*rega))) {
+			if (!canCall(*rega))
+				*rega = getProperty(th, *(rega+1), *rega);
+			if (isYieldMeth(meth) || (isMethod(*rega) && isYieldMeth(*rega)) || isYielder(*rega)) {
+				Value stackless = isStacklessCI(th, ci)? *ci->methodbase : aNull;
 				getCall(th, b, bc_c(i)); // Call
+				ci = th(th)->curmethod; // Call stack may have moved
+				rega = ci->begin + bc_a(i); // ... and so may the data stack
 
 				// Return: Calculate how any we have to copy down and how many nulls for padding
 				AintIdx have = th(th)->stk_top - rega; // Get all up to top
@@ -695,7 +1171,11 @@ void methodRunBC(Value th) {
 					*to++ = aNull;  // Fill rest with nulls
 
 				// Back up for thread switching
-				if (isYielder(th)) {
+				if (stackless != aNull) {
+					th(stackless)->flags1 |= ThreadDone;
+					ci = --th(th)->curmethod;
+				}
+				else if (isYielder(th) && ci==thrEntryCI(th)) {
 					// Mark that yielder is finished and cannot be used further
 					th(th)->flags1 |= ThreadDone;
 					// Switch current thread to caller
@@ -704,7 +1184,7 @@ void methodRunBC(Value th) {
 				}
 				else
 					// Back up a frame
-					ci = th(th)->curmethod = ci->previous;
+					ci = --th(th)->curmethod;
 				th(th)->stk_top = to; // Mark position of last returned
 
 				// Return to 'c' method caller, if we were called from there
@@ -718,10 +1198,7 @@ void methodRunBC(Value th) {
 			}
 			else {
 				// Prepare call frame and stack, then perform the call
-				if (!canCall(*rega))
-					*rega = getProperty(th, *(rega+1), *rega);
 				switch (canCallMorC(*rega)? tailcallMorCPrep(th, rega, 0)
-					: isYielder(*rega)? callYielderPrep(th, rega, bc_c(i), 0)
 					: returnNulls(th)) {
 				case MethodC:
 					return; // Return to C caller on bad tailcall attempt
@@ -732,13 +1209,13 @@ void methodRunBC(Value th) {
 			}
 			lits = meth->lits;
 			stkbeg = ci->begin;
-			} break;
+			} vmbreak;
 
 		// OpReturn: retTo(0 .. wanted) := R(A .. A+B-1); Return
 	    //	if (B == 0xFF), it uses Top-1 (resets Top) rather than A+B-1 (Top=End)
 		//	Caller sets retTo and wanted (if 0xFF, all return values)
 		//  Return restores previous frame
-		case OpReturn:
+		vmcase(OpReturn)
 		{
 			// Calculate how any we have to copy down and how many nulls for padding
 			AintIdx have = bc_b(i); // return values we have
@@ -751,6 +1228,10 @@ void methodRunBC(Value th) {
 				else /* if (have < want) */ nulls = want - have; // need some null padding
 			}
 
+			// A finished stackless yielder cannot be resumed
+			if (isStacklessCI(th, ci))
+				th(*ci->methodbase)->flags1 |= ThreadDone;
+
 			// Copy return values into previous frame's data stack
 			Value *from = rega;
 			Value *to = th(th)->curmethod->retTo;
@@ -760,7 +1241,7 @@ void methodRunBC(Value th) {
 				*to++ = aNull;  // Fill rest with nulls
 
 			// Back up differently for thread switching vs. frame rollback
-			if (isYielder(th) && ci==&th(th)->entrymethod) {
+			if (isYielder(th) && ci==thrEntryCI(th)) {
 				// Mark that yielder is finished and cannot be used further
 				th(th)->flags1 |= ThreadDone;
 
@@ -770,7 +1251,7 @@ void methodRunBC(Value th) {
 			}
 			else
 				// Back up a frame
-				ci = th(th)->curmethod = ci->previous;
+				ci = --th(th)->curmethod;
 			th(th)->stk_top = to; // Mark position of last returned
 
 			// Return to 'c' method caller, if we were called from there
@@ -784,13 +1265,13 @@ void methodRunBC(Value th) {
 			lits = meth->lits; 
 			stkbeg = ci->begin;
 			}
-			break;
+			vmbreak;
 
 		// OpYield: retTo(0 .. wanted) := R(A .. A+B-1); expect := C. Return.
 	    //	if (B == 0xFF), it uses Top-1 (resets Top) rather than A+B-1 (Top=End)
 		//	Caller sets retTo and wanted (if 0xFF, all return values)
 		//  Return restores previous thread
-		case OpYield:
+		vmcase(OpYield)
 		{
 			// Calculate how many return values we have to copy down and how many nulls for padding
 			AintIdx have = bc_b(i); // return values we have
@@ -803,6 +1284,19 @@ void methodRunBC(Value th) {
 				else /* if (have < want) */ nulls = want - have; // need some null padding
 			}
 
+			// A stackless yielder saves its registers, to resume with,
+			// and where the values passed back in should go
+			bool stackless = isStacklessCI(th, ci);
+			if (stackless) {
+				ThreadInfo *yielder = th(*ci->methodbase);
+				CallInfo *ycf = yielder->curmethod;
+				memcpy(ycf->begin, stkbeg, meth->maxstacksize*sizeof(Value));
+				yielder->stk_top = ycf->begin + meth->maxstacksize;
+				ycf->retTo = ycf->begin + bc_a(i);
+				ycf->ip = ci->ip;
+				ycf->nresults = bc_c(i);
+			}
+
 			// Copy return values into previous frame's data stack
 			Value *from = rega;
 			Value *to = th(th)->curmethod->retTo;
@@ -811,13 +1305,18 @@ void methodRunBC(Value th) {
 			while (nulls--)
 				*to++ = aNull;  // Fill rest with nulls
 
-			// Fix yielder stack pointer for callback
-			th(th)->stk_top = rega;
-			ci->nresults = bc_c(i);
+			if (stackless)
+				// Back up a frame
+				ci = --th(th)->curmethod;
+			else {
+				// Fix yielder stack pointer for callback
+				th(th)->stk_top = rega;
+				ci->nresults = bc_c(i);
 
-			// Switch current thread/frame to caller
-			th = th(th)->yieldTo;
-			ci = th(th)->curmethod;
+				// Switch current thread/frame to caller
+				th = th(th)->yieldTo;
+				ci = th(th)->curmethod;
+			}
 
 			// Mark position of last returned
 			th(th)->stk_top = to; // Mark position of last returned
@@ -835,12 +1334,218 @@ void methodRunBC(Value th) {
 			lits = meth->lits; 
 			stkbeg = ci->begin;
 			}
-			break;
+			vmbreak;
+
+		// OpAdd: R(A) := R(B) + R(C)
+		vmcase(OpAdd)
+			vmarith(SymPlus, OpAddInt, vmAddInt, OpAddFloat, vmAddFloat);
+			vmbreak;
+
+		// OpSub: R(A) := R(B) - R(C)
+		vmcase(OpSub)
+			vmarith(SymMinus, OpSubInt, vmSubInt, OpSubFloat, vmSubFloat);
+			vmbreak;
+
+		// OpMul: R(A) := R(B) * R(C)
+		vmcase(OpMul)
+			vmarith(SymMult, OpMulInt, vmMulInt, OpMulFloat, vmMulFloat);
+			vmbreak;
+
+		// OpDiv: R(A) := R(B) / R(C). Integer divide by zero is null.
+		vmcase(OpDiv)
+			vmarith(SymDiv, OpDivInt, vmDivInt, OpDivFloat, vmDivFloat);
+			vmbreak;
+
+		// OpRocket: R(A) := R(B) <=> R(C)
+		// Integer and Float pairs are compared inline (quickening the instruction),
+		// performing any conditional jump on R(A) that follows. Otherwise '<=>' is
+		// called (using R(A) .. R(A+2)) and the jump is done after it returns.
+		vmcase(OpRocket) {
+			Value x = *(stkbeg + bc_b(i));
+			Value y = *(stkbeg + bc_c(i));
+			int cmp;
+			if (isInt(x) && isInt(y) && vm(th)->fastnumops) {
+				vmquicken(OpRocketInt);
+				cmp = vmRocketInt;
+			}
+			else if (isFloat(x) && isFloat(y) && vm(th)->fastnumops) {
+				vmquicken(OpRocketFloat);
+				cmp = vmRocketFloat;
+			}
+			else {
+				*rega = getProperty(th, x, vmlit(SymRocket));
+				*(rega+1) = x;
+				*(rega+2) = y;
+				th(th)->stk_top = rega+3;
+				methCall(rega, 1, 0);
+				vmbreak;
+			}
+			vmrocketresult(cmp);
+			} vmbreak;
+
+		// OpLoadLitReg: R(A) := Literals(C); R(A+1) := R(B)
+		// (a method's symbol and self, ahead of its call)
+		vmcase(OpLoadLitReg)
+			*(rega+1) = *(stkbeg + bc_b(i));
+			*rega = *(lits + bc_c(i));
+			vmbreak;
+
+		// Quickened ops: a generic op above rewrites itself to one of these after seeing
+		// its operands' types. Each guards that its operands still have those types,
+		// and if not, rewrites itself back to the generic op and has it run instead.
+		vmcase(OpAddInt)
+			vmquickarith(isInt, OpAdd, vmAddInt);
+			vmbreak;
+		vmcase(OpAddFloat)
+			vmquickarith(isFloat, OpAdd, vmAddFloat);
+			vmbreak;
+		vmcase(OpSubInt)
+			vmquickarith(isInt, OpSub, vmSubInt);
+			vmbreak;
+		vmcase(OpSubFloat)
+			vmquickarith(isFloat, OpSub, vmSubFloat);
+			vmbreak;
+		vmcase(OpMulInt)
+			vmquickarith(isInt, OpMul, vmMulInt);
+			vmbreak;
+		vmcase(OpMulFloat)
+			vmquickarith(isFloat, OpMul, vmMulFloat);
+			vmbreak;
+		vmcase(OpDivInt)
+			vmquickarith(isInt, OpDiv, vmDivInt);
+			vmbreak;
+		vmcase(OpDivFloat)
+			vmquickarith(isFloat, OpDiv, vmDivFloat);
+			vmbreak;
+		vmcase(OpRocketInt) {
+			Value x = *(stkbeg + bc_b(i));
+			Value y = *(stkbeg + bc_c(i));
+			if (isInt(x) && isInt(y) && vm(th)->fastnumops)
+				vmrocketresult(vmRocketInt)
+			else {
+				vmquicken(OpRocket);
+				ci->ip--;
+			}
+			} vmbreak;
+		vmcase(OpRocketFloat) {
+			Value x = *(stkbeg + bc_b(i));
+			Value y = *(stkbeg + bc_c(i));
+			if (isFloat(x) && isFloat(y) && vm(th)->fastnumops)
+				vmrocketresult(vmRocketFloat)
+			else {
+				vmquicken(OpRocket);
+				ci->ip--;
+			}
+			} vmbreak;
+
+		// OpEachList: R(A+4), R(A+5) := index and element of List R(A+3) at R(A+1)
+		vmcase(OpEachList) {
+			vmeachguard(EachList, OpEachCall);
+			Value list = *(rega+3);
+			AuintIdx idx = toAint(*(rega+1));
+			if (idx < arr_size(list)) {
+				*(rega+1) = anInt(idx+1);
+				vmeachresults(anInt(idx), arrGet(th, list, idx));
+			}
+			else
+				*(rega+4) = aNull;
+			} vmbreak;
+
+		// OpEachRange: R(A+4), R(A+5) := true and R(A+1), stepping R(A+1) by R(A+3) up to R(A+2)
+		vmcase(OpEachRange) {
+			vmeachguard(EachRange, OpEachCall);
+			Value cur = *(rega+1);
+			if (isInt(cur)) {
+				Aint curi = toAint(cur);
+				Aint toi = toAint(*(rega+2));
+				Aint stepi = toAint(*(rega+3));
+				if (vmrangedone(stepi, curi, toi)) {
+					*(rega+4) = aNull;
+					vmbreak;
+				}
+				*(rega+1) = anInt(curi + stepi);
+			}
+			else {
+				Afloat curf = toAfloat(cur);
+				Afloat tof = toAfloat(*(rega+2));
+				Afloat stepf = toAfloat(*(rega+3));
+				if (vmrangedone(stepf, curf, tof)) {
+					*(rega+4) = aNull;
+					vmbreak;
+				}
+				*(rega+1) = aFloat(curf + stepf);
+			}
+			vmeachresults(aTrue, cur);
+			} vmbreak;
+
+		// OpEachIndex: R(A+4), R(A+5) := key and value of Index R(A+3)'s node at or after R(A+1)
+		vmcase(OpEachIndex) {
+			vmeachguard(EachIndex, OpEachCall);
+			Value key, val;
+			AuintIdx pos = tblIterate(*(rega+3), toAint(*(rega+1)), &key, &val);
+			if (pos) {
+				*(rega+1) = anInt(pos);
+				vmeachresults(key, val);
+			}
+			else
+				*(rega+4) = aNull;
+			} vmbreak;
+
+		// OpEachText: R(A+4), R(A+5) := index and character of Text R(A+3) at byte R(A+1)
+		vmcase(OpEachText) {
+			vmeachguard(EachText, OpEachCall);
+			Value text = *(rega+3);
+			AuintIdx pos = toAint(*(rega+1));
+			if (pos < str_size(text)) {
+				const char *textp = toStr(text) + pos;
+				AuintIdx charsz = utf8_charsize(textp);
+				Aint charidx = toAint(*(rega+2));
+				*(rega+1) = anInt(pos + charsz);
+				*(rega+2) = anInt(charidx + 1);
+				vmeachresults(anInt(charidx), aNull);
+				if (bc_c(i) > 1)
+					newStr(th, rega+5, vmlit(TypeTextm), textp, charsz);
+			}
+			else
+				*(rega+4) = aNull;
+			} vmbreak;
+
+		// OpForLoopInt: R(A+1) += R(A+3). If still within R(A+2): R(A+4), R(A+5) := true, R(A+1), ip += sBx
+		vmcase(OpForLoopInt) {
+			vmeachguard(ForInt, OpForLoop);
+			Aint stepi = toAint(*(rega+3));
+			Aint curi = toAint(*(rega+1)) + stepi;
+			Aint toi = toAint(*(rega+2));
+			if (!vmrangedone(stepi, curi, toi)) {
+				*(rega+1) = *(rega+5) = anInt(curi);
+				*(rega+4) = aTrue;
+				ci->ip += bc_j(i);
+				vmjit();
+			}
+			} vmbreak;
+
+		// OpForLoopFloat: R(A+1) += R(A+3). If still within R(A+2): R(A+4), R(A+5) := true, R(A+1), ip += sBx
+		vmcase(OpForLoopFloat) {
+			vmeachguard(ForFloat, OpForLoop);
+			Afloat stepf = toAfloat(*(rega+3));
+			Afloat curf = toAfloat(*(rega+1)) + stepf;
+			Afloat tof = toAfloat(*(rega+2));
+			if (!vmrangedone(stepf, curf, tof)) {
+				*(rega+1) = *(rega+5) = aFloat(curf);
+				*(rega+4) = aTrue;
+				ci->ip += bc_j(i);
+				vmjit();
+			}
+			} vmbreak;
 
 		// Should never reach here
+#ifdef AVM_COMPUTEDGOTO
+		L_OpExtraArg:
+#else
 		default:
+#endif
 			assert(0 && "Invalid byte code");
-			break;
+			vmbreak;
 	}
   }
 }
@@ -888,6 +1593,189 @@ void setCall(Value th, int nparms, int nexpected) {
 	}
 }
 
+/** Fail verification (from inside methodVerify) if the condition is not met */
+#define verifyCheck(cond, why) \
+	do { \
+		if (!(cond)) { \
+			vmLog("Bytecode verification failed at instruction %d: %s", (int)ip, why); \
+			return false; \
+		} \
+	} while (0)
+
+/** Fail verification (from inside methodVerify) if the register is not in the frame */
+#define verifyReg(reg) verifyCheck((reg) < nregs, "register beyond stack size")
+
+/* Verify that a bytecode method's instructions are safe to run without checks:
+ * every register operand is within the frame's maxstacksize, every literal index
+ * is below nbrlits, every property cache index is below nbrpropcache, every standard
+ * symbol is defined, closure variable indexes are past the closure's methods, every jump
+ * lands on an instruction, OpExtraArg only follows the instructions that need it,
+ * and the last instruction does not let execution fall off the end.
+ * Registers for a variable number of values (BCVARRET) grow the stack as needed.
+ * On success, the method is marked as verified and true is returned. */
+bool methodVerify(Value th, Value methval) {
+	BMethodInfo *meth = (BMethodInfo*) methval;
+	Instruction *code = meth->code;
+	AuintIdx size = meth->size;
+	AuintIdx nregs = meth->maxstacksize;
+	AuintIdx ip = 0;
+
+	verifyCheck(size > 0, "no instructions");
+	verifyCheck(methodNParms(meth) <= meth->nbrlocals && meth->nbrlocals <= nregs, "locals beyond stack size");
+
+	for (ip=0; ip<size; ip++) {
+		Instruction i = code[ip];
+		BCOp op = bc_op(i);
+		BCReg a = bc_a(i), b = bc_b(i), c = bc_c(i);
+		bool extra = false; // Must be followed by OpExtraArg
+
+		switch (op) {
+		case OpLoadReg:
+			verifyReg(a); verifyReg(b);
+			break;
+		case OpLoadRegs:
+			if (c > 0) {
+				verifyReg(a+c-1); verifyReg(b+c-1);
+			}
+			break;
+		case OpLoadLit:
+			verifyReg(a);
+			verifyCheck(bc_bx(i) < meth->nbrlits, "literal beyond literals");
+			break;
+		case OpLoadLitx:
+			verifyReg(a);
+			verifyCheck(ip+1 < size && bc_ax(code[ip+1]) < meth->nbrlits, "literal beyond literals");
+			extra = true;
+			break;
+		case OpLoadPrim:
+			verifyReg(a);
+			verifyCheck(b <= 2, "unknown primitive");
+			break;
+		case OpLoadNulls:
+			verifyReg(a+b);
+			break;
+		case OpLoadContext:
+			verifyReg(a);
+			verifyCheck(b <= 1, "unknown context");
+			break;
+		case OpLoadVararg:
+			verifyReg(b==BCVARRET || b==0? a : a+b-1);
+			break;
+		case OpGetGlobal: case OpSetGlobal:
+			verifyReg(a);
+			verifyCheck(bc_bx(i) < meth->nbrlits && isArr(meth->lits[bc_bx(i)]), "global without a bound cell");
+			break;
+		case OpGetClosure: case OpSetClosure:
+			verifyReg(a);
+			verifyCheck(b >= 2, "closure variable index is a closure method");
+			break;
+		case OpNewClosure:
+			verifyCheck(b >= 2, "closure without get and set methods");
+			verifyReg(a+b-1);
+			break;
+		case OpJump:
+		case OpJNull: case OpJNNull: case OpJTrue: case OpJFalse:
+		case OpJEq: case OpJNe: case OpJLt: case OpJLe: case OpJGt: case OpJGe:
+		case OpJEqN: case OpJNeN: case OpJLtN: case OpJLeN: case OpJGtN: case OpJGeN:
+		case OpJSame: case OpJDiff: {
+			if (op != OpJump)
+				verifyReg(op==OpJSame || op==OpJDiff? a+1 : a);
+			AintIdx dest = (AintIdx)ip + 1 + bc_j(i);
+			verifyCheck(dest >= 0 && dest < (AintIdx)size && bc_op(code[dest]) != OpExtraArg, "jump out of bounds");
+			} break;
+		case OpLoadStd:
+			verifyReg(a+1); verifyReg(b);
+			verifyCheck(c < getSize(vm(th)->stdidx), "unknown standard symbol");
+			break;
+		case OpGetMeth:
+			verifyReg(a+1);
+			break;
+		case OpGetProp:
+			verifyReg(a+1);
+			extra = true;
+			break;
+		case OpGetActProp:
+			verifyReg(a+1);
+			if (c > 0 && c != BCVARRET)
+				verifyReg(a+c-1);
+			extra = true;
+			break;
+		case OpSetProp: case OpSetActProp:
+			verifyReg(a+2);
+			break;
+		case OpGetCall: case OpSetCall: case OpTailCall:
+			verifyReg(b==BCVARRET? a : a+b);
+			if (op != OpTailCall && c > 0 && c != BCVARRET)
+				verifyReg(a+c-1);
+			extra = op == OpGetCall;
+			break;
+		case OpEachCall:
+			verifyReg(b==BCVARRET? a+3 : a+3+b);
+			verifyReg(a+4);
+			if (c > 0 && c != BCVARRET)
+				verifyReg(a+3+c);
+			break;
+		case OpReturn: case OpYield:
+			verifyReg(b==BCVARRET || b==0? a : a+b-1);
+			break;
+		case OpEachPrep:
+			verifyReg(a+4); verifyReg(b);
+			break;
+		case OpEachSplat:
+			verifyReg(a+2);
+			break;
+		case OpForPrep: case OpForLoop: {
+			verifyReg(a+5);
+			AintIdx dest = (AintIdx)ip + 1 + bc_j(i);
+			verifyCheck(dest >= 0 && dest < (AintIdx)size && bc_op(code[dest]) != OpExtraArg, "jump out of bounds");
+			if (op == OpForPrep)
+				verifyCheck(bc_op(code[dest]) == OpForLoop && bc_a(code[dest]) == a && dest+1 < (AintIdx)size, "for loop without its step");
+			} break;
+		case OpSwitch: {
+			verifyReg(a);
+			AintIdx dest = (AintIdx)ip + 1 + bc_j(i);
+			verifyCheck(dest >= 0 && dest < (AintIdx)size && bc_op(code[dest]) != OpExtraArg, "jump out of bounds");
+			verifyCheck(ip+1 < size && bc_op(code[ip+1]) == OpExtraArg && bc_ax(code[ip+1]) < meth->nbrlits
+				&& isTbl(meth->lits[bc_ax(code[ip+1])]), "switch without its Index");
+			Value tbl = meth->lits[bc_ax(code[ip+1])];
+			Value key, val;
+			AuintIdx pos = 0;
+			while ((pos = tblIterate(tbl, pos, &key, &val)))
+				verifyCheck(isInt(val) && toAint(val) >= 0 && toAint(val) < (Aint)size
+					&& bc_op(code[toAint(val)]) != OpExtraArg, "switch out of bounds");
+			extra = true;
+			} break;
+		case OpAdd: case OpSub: case OpMul: case OpDiv: case OpRocket:
+			verifyReg(a+2); verifyReg(b); verifyReg(c);
+			break;
+		case OpLoadLitReg:
+			verifyReg(a+1); verifyReg(b);
+			verifyCheck(c < meth->nbrlits, "literal beyond literals");
+			break;
+		default:
+			verifyCheck(false, op==OpExtraArg? "misplaced extra argument" : "unknown operation");
+		}
+
+		// Consume the extra argument, whose property cache index (if any) must be allocated
+		if (extra) {
+			verifyCheck(ip+1 < size && bc_op(code[ip+1]) == OpExtraArg, "missing extra argument");
+			ip++;
+			verifyCheck(op == OpLoadLitx || op == OpSwitch || bc_ax(code[ip]) < meth->nbrpropcache, "property cache beyond caches");
+		}
+	}
+
+	// Execution must not run off the end
+	ip = size-1;
+	verifyCheck(bc_op(code[ip]) == OpReturn || bc_op(code[ip]) == OpTailCall || bc_op(code[ip]) == OpJump, "code does not end with a return");
+
+	// Only this copy is run, so its instructions may be quickened without losing the original
+	mem_reallocvector(th, meth->runcode, 0, size, Instruction);
+	memcpy(meth->runcode, code, size*sizeof(Instruction));
+
+	methodFlags(meth) |= METHOD_FLG_VERIFIED;
+	return true;
+}
+
 /** Serialize a,b,c for an op code */
 void methABCSerialize(Value th, Value str, const char *op, Instruction i) {
 	strAppend(th, str, op, strlen(op));
@@ -935,14 +1823,16 @@ void methSerialize(Value th, Value str, int indent, Value method) {
 		case OpLoadRegs: methABCSerialize(th, str, "LoadRegs ", i); break;
 		case OpLoadLit: methALSerialize(th, str, "LoadLit ", i, *(lits + bc_bx(i))); break;
 		case OpLoadLitx: methALSerialize(th, str, "LoadLitx ", i, *(lits + bc_ax(i))); ip++; break;
+		case OpExtraArg: strAppend(th, str, "ExtraArg ", 9); serialize(th, str, 0, anInt(bc_ax(i))); break;
 		case OpLoadPrim: methALSerialize(th, str, "LoadPrim ", i, (Value)((((Auint)bc_b(i)) << ValShift) + ValCons)); break;
 		case OpLoadNulls: methABCSerialize(th, str, "LoadNulls ", i); break;
 		case OpLoadContext: methABCSerialize(th, str, "LoadContext ", i); break;
 		case OpLoadVararg: methABCSerialize(th, str, "LoadVararg ", i); break;
-		case OpGetGlobal: methALSerialize(th, str, "GetGlobal ", i, *(lits + bc_bx(i))); break;
-		case OpSetGlobal: methALSerialize(th, str, "SetGlobal ", i, *(lits + bc_bx(i))); break;
+		case OpGetGlobal: methALSerialize(th, str, "GetGlobal ", i, arrGet(th, *(lits + bc_bx(i)), 1)); break;
+		case OpSetGlobal: methALSerialize(th, str, "SetGlobal ", i, arrGet(th, *(lits + bc_bx(i)), 1)); break;
 		case OpGetClosure: methABCSerialize(th, str, "GetClosure ", i); break;
 		case OpSetClosure: methABCSerialize(th, str, "SetClosure ", i); break;
+		case OpNewClosure: methABCSerialize(th, str, "NewClosure ", i); break;
 		case OpJump: methALSerialize(th, str, "Jump ", i, anInt(ip+bc_j(i)+1)); break;
 		case OpJNull: methALSerialize(th, str, "JNull ", i, anInt(ip+bc_j(i)+1)); break;
 		case OpJNNull: methALSerialize(th, str, "JNNull ", i, anInt(ip+bc_j(i)+1)); break;
@@ -966,6 +1856,9 @@ void methSerialize(Value th, Value str, int indent, Value method) {
 		case OpEachPrep: methABCSerialize(th, str, "EachPrep ", i); break;
 		case OpEachSplat: methABCSerialize(th, str, "EachSplat ", i); break;
 		case OpEachCall: methABCSerialize(th, str, "EachCall ", i); break;
+		case OpForPrep: methALSerialize(th, str, "ForPrep ", i, anInt(ip+bc_j(i)+1)); break;
+		case OpForLoop: methALSerialize(th, str, "ForLoop ", i, anInt(ip+bc_j(i)+1)); break;
+		case OpSwitch: methALSerialize(th, str, "Switch ", i, anInt(ip+bc_j(i)+1)); break;
 		case OpGetMeth: methABCSerialize(th, str, "GetMeth ", i); break;
 		case OpGetProp: methABCSerialize(th, str, "GetProp ", i); break;
 		case OpSetProp: methABCSerialize(th, str, "SetProp ", i); break;
@@ -976,6 +1869,12 @@ void methSerialize(Value th, Value str, int indent, Value method) {
 		case OpTailCall:  methABCSerialize(th, str, "TailCall ", i); break;
 		case OpReturn: methABCSerialize(th, str, "Return ", i); break;
 		case OpYield: methABCSerialize(th, str, "Yield ", i); break;
+		case OpAdd: methABCSerialize(th, str, "Add ", i); break;
+		case OpSub: methABCSerialize(th, str, "Sub ", i); break;
+		case OpMul: methABCSerialize(th, str, "Mul ", i); break;
+		case OpDiv: methABCSerialize(th, str, "Div ", i); break;
+		case OpRocket: methABCSerialize(th, str, "Rocket ", i); break;
+		case OpLoadLitReg: methABSSerialize(th, str, "LoadLitReg ", i, *(lits + bc_c(i))); break;
 		default: strAppend(th, str, "Unknown Opcode", 14);
 		}
 	}
@@ -135,9 +135,9 @@ Value pushClosure(Value th, AintIdx size) {
 	assert(size>=2 && stkSz(th)>=size); // All closure variables should be on stack
 	stkCanIncTop(th); /* Check if there is room */
 	closure = newClosure(th, th(th)->stk_top++, vmlit(TypeClom),  size);
-	// Copy closure variables into closure
-	for (int i=0; i<size; i++)
-		arrSet(th, closure, i, *(th(th)->stk_top-size-1+i));
+	// Copy closure variables into closure (a new closure needs no mark check)
+	memcpy(arr_info(closure)->arr, th(th)->stk_top-size-1, size*sizeof(Value));
+	arr_info(closure)->size = size;
 	*(th(th)->stk_top-size-1) = closure; // move created closure down
 	th(th)->stk_top -= size; // pop off closure variables
 	return closure;
@@ -166,6 +166,12 @@ Value pushTbl(Value th, Value type, AuintIdx size) {
 	return newTbl(th, th(th)->stk_top++, (type==aNull)? vmlit(TypeIndexm) : type, size);
 }
 
+/* Push and return a new hashed table value whose Text keys match by content */
+Value pushTextTbl(Value th, Value type, AuintIdx size) {
+	stkCanIncTop(th); /* Check if there is room */
+	return newTextTbl(th, th(th)->stk_top++, (type==aNull)? vmlit(TypeTextIndexm) : type, size);
+}
+
 /* Push and return a new Type value */
 Value pushType(Value th, Value type, AuintIdx size) {
 	stkCanIncTop(th); /* Check if there is room */
@@ -408,15 +414,21 @@ void stkRealloc(Value th, int newsize) {
 
 	// Correct all data stack pointers, given that data stack may have moved in memory
 	if (oldstack) {
+		// Rebase each pointer by its offset into the old stack: the distance
+		// between the old and new blocks themselves may not fit an AintIdx
 		CallInfo *ci;
-		AintIdx shift = th(th)->stack - oldstack;
-		th(th)->stk_top = th(th)->stk_top + shift;
-		for (ci = th(th)->curmethod; ci != NULL; ci = ci->previous) {
-			ci->end += shift;
-			ci->methodbase += shift;
-			ci->retTo += shift;
-			ci->begin += shift;
+		Value *newstack = th(th)->stack;
+#define stkRebase(p) ((p) = newstack + ((p) - oldstack))
+		stkRebase(th(th)->stk_top);
+		for (ci = th(th)->curmethod; ci >= th(th)->calls; ci--) {
+			stkRebase(ci->end);
+			stkRebase(ci->methodbase);
+			// A yielder's entry frame returns into its caller's stack, which has not moved
+			if (ci != th(th)->calls || !(th(th)->flags1 & ThreadYielder))
+				stkRebase(ci->retTo);
+			stkRebase(ci->begin);
 		}
+#undef stkRebase
 	}
 }
 
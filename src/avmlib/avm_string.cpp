@@ -24,6 +24,7 @@ Value newStr(Value th, Value *dest, Value type, const char *str, AuintIdx len) {
 	val->flags1 = 0;
 	val->flags2 = 0;
 	val->type = type;
+	val->hash = 0;
 
 	val->avail = len;
 	val->str = (char*) mem_gcrealloc(th, NULL, 0, len+1); // an extra byte for 0-terminator
@@ -58,6 +59,7 @@ Value newCData(Value th, Value *dest, Value type, unsigned char cdatatyp, AuintI
 	val->flags1 = StrCData | extrahdr;
 	val->flags2 = cdatatyp;
 	val->type = type;
+	val->hash = 0;
 
 	val->size = 0;
 	val->avail = len;
@@ -110,6 +112,7 @@ const void *toHeader(Value str) {
  * Allocated space will not shrink. Changes nothing about string's contents. */
 void strMakeRoom(Value th, Value val, AuintIdx len) {
 	StrInfo *str = str_info(val);
+	str->hash = 0; // The caller is likely about to change its contents
 
 	/* Expand available space, if needed */
 	if (len > str->avail) {
@@ -131,6 +134,7 @@ void strSwapBuffer(Value th, Value val, char *buffer, AuintIdx len) {
 
 	// Plug in new buffer along with sizing info
 	str->str = buffer;
+	str->hash = 0;
 	str->size = str->avail = len - 1; // One less to follow convention for buffers we allocate
 
 	// Keep GC memory accounting accurate
@@ -170,6 +174,7 @@ void strSub(Value th, Value val, AuintIdx pos, AuintIdx sz, const char *repstr,
 	/* Adjust size and place 0-terminator */
 	str->size = len;
 	str->str[len] = '\0';
+	str->hash = 0;
 }
 
 #include <stdio.h>
@@ -196,6 +201,23 @@ void strAppend(Value th, Value val, const char *addstr, AuintIdx addstrlen) {
 	/* Adjust size and place 0-terminator */
 	str->size = newlen;
 	str->str[newlen] = '\0';
+	str->hash = 0;
+}
+
+/* Return the hash of a string's contents, calculating it only the first time */
+AuintIdx str_hash(Value th, Value val) {
+	return str_seedhash(val, vm(th)->hashseed);
+}
+
+/* Like str_hash, for callers without a thread, which pass the VM's hashseed */
+AuintIdx str_seedhash(Value val, AuintIdx seed) {
+	StrInfo *str = str_info(val);
+	if (str->hash == 0) {
+		str->hash = tblCalcStrHash(str->str, str->size, seed);
+		if (str->hash == 0)
+			str->hash = 1;  // 0 means not yet calculated
+	}
+	return str->hash;
 }
 
 /* Return a read-only pointer into a C-string encoded by a symbol or string-oriented Value. 
@@ -19,40 +19,72 @@ extern "C" {
 #define hash_binmod(s,size) \
 	(assert_exp((size&(size-1))==0, (AuintIdx) ((s) & ((size)-1)) ))
 
-/** Resize the symbol table */
-void sym_resize_tbl(Value th, Auint newsize) {
-	SymTable* sym_tbl = &vm(th)->sym_table;
-	Auint i;
-
-	// If we need to grow, allocate more cleared space for array
-	if (newsize > sym_tbl->nbrAvail) {
-		//mem_gccheck(th);	// Incremental GC before memory allocation events
-		mem_reallocvector(th, sym_tbl->symArray, sym_tbl->nbrAvail, newsize, SymInfo *);
-		for (i = sym_tbl->nbrAvail; i < newsize; i++) 
-			sym_tbl->symArray[i] = NULL;
+/** Return the slot holding the symbol for str in an array of slots, or NULL if not there.
+ * Probing stops at a never-used slot; there is always one, as arrays are never full. */
+SymSlot *sym_find(SymSlot *slots, Auint avail, AuintIdx hash, const char *str, Auint len) {
+	for (Auint i = hash_binmod(hash, avail); ; i = hash_binmod(i+1, avail)) {
+		SymSlot *slot = &slots[i];
+		if (slot->sym == NULL)
+			return NULL;
+		if (slot->hash == hash && sym_isused(slot->sym) &&
+				len == slot->sym->size &&
+				(memcmp(str, sym_cstr(slot->sym), len) == 0))
+			return slot;
 	}
+}
+
+/** Put a symbol not yet in symArray into the first free slot it probes */
+void sym_place(SymTable *sym_tbl, SymInfo *sym, AuintIdx hash) {
+	Auint i = hash_binmod(hash, sym_tbl->nbrAvail);
+	while (sym_isused(sym_tbl->symArray[i].sym))
+		i = hash_binmod(i+1, sym_tbl->nbrAvail);
+	if (sym_tbl->symArray[i].sym == SymDeleted)
+		sym_tbl->nbrDeleted--;
+	sym_tbl->symArray[i].sym = sym;
+	sym_tbl->symArray[i].hash = hash;
+}
 
-	// Move all symbols to re-hashed positions in array
-	for (i=0; i<sym_tbl->nbrAvail; i++) {
-		SymInfo *p = sym_tbl->symArray[i];
-		sym_tbl->symArray[i] = NULL;
-		while (p) {  // for each node in the list
-			SymInfo *next = (SymInfo*) p->next;  // save next
-			AuintIdx h = hash_binmod(p->hash, newsize);  // new position
-			p->next = (MemInfo*) sym_tbl->symArray[h];  // chain it
-			sym_tbl->symArray[h] = (SymInfo*) p;
-			resetoldbit(p);  // see MOVE OLD rule
-			p = next;
+/** Move up to count of oldArray's slots to symArray, freeing oldArray once all have moved */
+void sym_rehash_step(Value th, Auint count) {
+	SymTable* sym_tbl = &vm(th)->sym_table;
+	for (; count && sym_tbl->oldMoved < sym_tbl->oldAvail; count--) {
+		SymSlot *slot = &sym_tbl->oldArray[sym_tbl->oldMoved++];
+		if (sym_isused(slot->sym)) {
+			sym_place(sym_tbl, slot->sym, slot->hash);
+			slot->sym = SymDeleted;  // Lookups must still probe past it
 		}
 	}
+	if (sym_tbl->oldMoved < sym_tbl->oldAvail)
+		return;
+
+	// All moved. symArray's slots are now numbered from 0, so move any sweep position back too
+	VmInfo *vm = vm(th);
+	vm->sweepsymgc = vm->sweepsymgc > sym_tbl->oldAvail? vm->sweepsymgc - sym_tbl->oldAvail : 0;
+	if (sym_tbl->oldArray)
+		mem_freearray(th, sym_tbl->oldArray, sym_tbl->oldAvail);
+	sym_tbl->oldArray = NULL;
+	sym_tbl->oldAvail = 0;
+	sym_tbl->oldMoved = 0;
+}
 
-	// Shrink array
-	if (newsize < sym_tbl->nbrAvail) {
-		// shrinking slice must be empty
-		assert(sym_tbl->symArray[newsize] == NULL && sym_tbl->symArray[sym_tbl->nbrAvail - 1] == NULL);
-		mem_reallocvector(th, sym_tbl->symArray, sym_tbl->nbrAvail, newsize, SymInfo *);
-	}
+/* Start moving the symbol table's symbols to a new array of newsize slots */
+void sym_resize_tbl(Value th, Auint newsize) {
+	SymTable* sym_tbl = &vm(th)->sym_table;
+
+	// Finish any earlier move first, so there are never more than two arrays
+	if (sym_tbl->oldArray)
+		sym_rehash_step(th, sym_tbl->oldAvail);
+
+	// The current array becomes the old one, keeping its slots' positions
+	sym_tbl->oldArray = sym_tbl->symArray;
+	sym_tbl->oldAvail = sym_tbl->nbrAvail;
+	sym_tbl->oldMoved = 0;
+	sym_tbl->symArray = NULL;
+	mem_reallocvector(th, sym_tbl->symArray, 0, newsize, SymSlot);
+	memset(sym_tbl->symArray, 0, newsize * sizeof(SymSlot));
 	sym_tbl->nbrAvail = newsize;
+	sym_tbl->nbrDeleted = 0;
+	sym_rehash_step(th, AVM_SYMREHASHSTEP);
 }
 
 /** Initialize the symbol table that hash indexes all symbols */
@@ -60,13 +92,34 @@ void sym_init(Value th) {
 	struct SymTable* sym_tbl = &vm(th)->sym_table;
 	sym_tbl->nbrAvail = 0;
 	sym_tbl->nbrUsed = 0;
+	sym_tbl->nbrDeleted = 0;
 	sym_tbl->symArray = NULL;
+	sym_tbl->oldArray = NULL;
+	sym_tbl->oldAvail = 0;
+	sym_tbl->oldMoved = 0;
+	sym_tbl->young = NULL;
+	sym_tbl->nbrYoung = 0;
+	sym_tbl->availYoung = 0;
 	sym_resize_tbl(th, AVM_SYMTBLMINSIZE);
 }
 
 /** Free the symbol table */
 void sym_free(Value th) {
-	mem_freearray(th, vm(th)->sym_table.symArray, vm(th)->sym_table.nbrAvail);
+	SymTable* sym_tbl = &vm(th)->sym_table;
+	if (sym_tbl->oldArray)
+		mem_freearray(th, sym_tbl->oldArray, sym_tbl->oldAvail);
+	mem_freearray(th, sym_tbl->symArray, sym_tbl->nbrAvail);
+	mem_freearray(th, sym_tbl->young, sym_tbl->availYoung);
+}
+
+/* Return the symbol table slot holding the symbol */
+SymSlot *sym_slotof(Value th, SymInfo *sym) {
+	SymTable* sym_tbl = &vm(th)->sym_table;
+	SymSlot *slot = sym_find(sym_tbl->symArray, sym_tbl->nbrAvail, sym->hash, sym_cstr(sym), sym->size);
+	if (slot == NULL)
+		slot = sym_find(sym_tbl->oldArray, sym_tbl->oldAvail, sym->hash, sym_cstr(sym), sym->size);
+	assert(slot && slot->sym == sym);
+	return slot;
 }
 
 /* If symbol exists in symbol table, reuse it. Otherwise, add it. 
@@ -74,32 +127,35 @@ void sym_free(Value th) {
 Value newSym(Value th, Value *dest, const char *str, AuintIdx len) {
 	SymInfo *sym;
 	SymTable* sym_tbl = &vm(th)->sym_table;
-	unsigned int hash = tblCalcStrHash(str, len, th(th)->vm->hashseed);
-
-	// Look for symbol in symbol table. Return it, if found.
-	for (sym = sym_tbl->symArray[hash_binmod(hash, sym_tbl->nbrAvail)]; sym != NULL; sym = (SymInfo*) sym->next) {
-		if (hash == sym->hash &&
-				len == sym->size &&
-				(memcmp(str, sym_cstr(sym), len) == 0)) {
-			mem_keepalive(th, (MemInfo*) sym); // Keep it alive, if it had been marked for deletion
-			return *dest = (Value) sym;
-		}
+	AuintIdx hash = tblCalcStrHash(str, len, th(th)->vm->hashseed);
+
+	// Look for symbol in symbol table (either array). Return it, if found.
+	SymSlot *slot = sym_find(sym_tbl->symArray, sym_tbl->nbrAvail, hash, str, len);
+	if (slot == NULL && sym_tbl->oldArray)
+		slot = sym_find(sym_tbl->oldArray, sym_tbl->oldAvail, hash, str, len);
+	if (slot) {
+		mem_keepalive(th, (MemInfo*) slot->sym); // Keep it alive, if it had been marked for deletion
+		return *dest = (Value) slot->sym;
 	}
 
-	// Not found. Double symbol table size if needed to hold another entry
-	if (sym_tbl->nbrUsed >= sym_tbl->nbrAvail)
-		sym_resize_tbl(th, sym_tbl->nbrAvail*2);
+	// Not found. Move a few more old symbols over, then start a new array
+	// if the current one is three-quarters full (doubling it, unless most of that is removed symbols)
+	if (sym_tbl->oldArray)
+		sym_rehash_step(th, AVM_SYMREHASHSTEP);
+	if (sym_tbl->nbrUsed + sym_tbl->nbrDeleted >= sym_tbl->nbrAvail - (sym_tbl->nbrAvail >> 2))
+		sym_resize_tbl(th, sym_tbl->nbrUsed >= (sym_tbl->nbrAvail >> 1)? sym_tbl->nbrAvail*2 : sym_tbl->nbrAvail);
 
-	// Create a symbol object, adding to symbol table at hash entry
+	// Create a symbol object, adding it to symbol table at its hash's first free slot
 	sym = (SymInfo *) mem_newnolink(th, SymEnc, sym_memsize(len));
-	MemInfo **linkp = (MemInfo**) &sym_tbl->symArray[hash_binmod(hash, sym_tbl->nbrAvail)];
-	sym->next = *linkp;
-	*linkp = (MemInfo*)sym;
+	sym->next = NULL;
 	sym->size = len;
 	sym->hash = hash;
 	memcpy(sym_cstr(sym), str, len);
 	(sym_cstr(sym))[len] = '\0';
+	sym_place(sym_tbl, sym, hash);
 	sym_tbl->nbrUsed++;
+	mem_growvector(th, sym_tbl->young, sym_tbl->nbrYoung, sym_tbl->availYoung, SymInfo*, INT_MAX);
+	sym_tbl->young[sym_tbl->nbrYoung++] = sym;
 	return *dest = (Value) sym;
 }
 
@@ -121,43 +177,34 @@ int isGlobal(Value sym) {
  */
 Value sym_next(Value th, Value key) {
 	SymTable *sym_tbl = &th(th)->vm->sym_table;
-	SymInfo *sym;
+	Auint pos = 0;
 
 	// If table empty, return null
 	if (sym_tbl->nbrUsed == 0)
 		return aNull;
 
-	// If key is null, return first symbol in table
-	if (key==aNull) {
-		SymInfo **symtblp = sym_tbl->symArray;
-		while ((sym=*symtblp++)==NULL);
-		return (Value) sym;
+	// Unless key is null, start just after the key's slot
+	if (key!=aNull) {
+		// If key is not a symbol, return null
+		if (!isSym(key))
+			return aNull;
+		SymInfo *sym = (SymInfo*) key;
+		SymSlot *slot = sym_find(sym_tbl->symArray, sym_tbl->nbrAvail, sym->hash, sym_cstr(sym), sym->size);
+		if (slot)
+			pos = sym_tbl->oldAvail + (slot - sym_tbl->symArray) + 1;
+		else if (sym_tbl->oldArray && (slot = sym_find(sym_tbl->oldArray, sym_tbl->oldAvail, sym->hash, sym_cstr(sym), sym->size)))
+			pos = (slot - sym_tbl->oldArray) + 1;
+		else
+			return aNull;
 	}
 
-	// If key is not a symbol, return null
-	if (!isSym(key))
-		return aNull;
-
-	// Look for the symbol in table, then return next one
-	AuintIdx hash = ((SymInfo*)key)->hash;
-	Auint len = ((SymInfo*)key)->size;
-	Auint i = hash_binmod(hash, sym_tbl->nbrAvail);
-	for (sym = sym_tbl->symArray[i]; sym != NULL; sym = (SymInfo*) sym->next) {
-		if (hash == sym->hash &&
-				len == sym->size &&
-				(memcmp(sym_cstr(key), sym_cstr(sym), len) == 0)) {
-			// If the next one is populated, return it
-			if ((sym = (SymInfo*) sym->next))
-				return (Value) sym;
-			// Look for next non-null entry in symbol array
-			for (i++; i<sym_tbl->nbrAvail; i++) {
-				if ((sym=sym_tbl->symArray[i]))
-					return (Value) sym;
-			}
-			return aNull; // No next symbol, return null
-		}
+	// Look for next used slot, across both arrays
+	for (; pos < sym_nbrslots(sym_tbl); pos++) {
+		SymSlot *slot = sym_slot(sym_tbl, pos);
+		if (sym_isused(slot->sym))
+			return (Value) slot->sym;
 	}
-	return aNull;
+	return aNull; // No next symbol, return null
 }
 
 
@@ -4,12 +4,20 @@
  * Changes to index size are always doubling or halving, so that size is a power of 2.
  * This restriction ensures that hash calculation is very easy and fast.
  *
- * Inspired by Lua, the implementation uses a mix of chained scatter table with Brent's variation.
+ * Inspired by Lua, the portable implementation uses a mix of chained scatter table with Brent's variation.
  * A main invariant of these tables is that, if an element is not
  * in its main position (i.e. the `original' position that its hash gives
  * to it), then the colliding element is in its own main position.
  * Hence even when the load factor reaches 100%, performance remains good.
  *
+ * Where AVM_SWISSTABLE is defined, the index instead uses open addressing with one-byte control
+ * tags probed 16 at a time (SSE2), as in Google's Swiss tables. Removed keys leave tombstones
+ * only where probing might otherwise stop short, and a full index with many of them is
+ * rebuilt at the same size rather than grown.
+ *
+ * Types and objects start out shaped instead (see avm_table.h): a lookup scans the shape's few keys
+ * for the slot holding the value, and adding a key follows (or creates) the shape's transition.
+ *
  * See avm_table.h for usage notes about keys.
  *
  * @file
@@ -20,18 +28,20 @@
 
 #include "avmlib.h"
 #include <string.h>
+#ifdef AVM_SWISSTABLE
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
 
 #ifdef __cplusplus
 namespace avm {
 extern "C" {
 #endif
 
-/** An empty Nodes structure, when a table's index has no entries (size of 0) */
-const struct Node emptyNode = {
-	aNull,
-	aNull,
-	NULL
-};
+void tblAdd(Value th, Value tbl, Value key, Value val);
+void tblRehash(Value th, Value tbl, Value key);
 
 /** Returns next highest integer value of log2(x) */
 unsigned char ceillog2(AuintIdx x) {
@@ -51,16 +61,364 @@ unsigned char ceillog2(AuintIdx x) {
 	return log + log_2[x];
 }
 
-/** Calculate the hash for a sequence of bytes (used by symbols). */
+/** Multiply two 64-bit numbers, returning the low half of the 128-bit product in *a and the high half in *b */
+static inline void tblMum(uint64_t *a, uint64_t *b) {
+#if defined(__SIZEOF_INT128__)
+	__uint128_t r = (__uint128_t) *a * *b;
+	*a = (uint64_t) r;
+	*b = (uint64_t) (r >> 64);
+#else
+	uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t) *a, lb = (uint32_t) *b;
+	uint64_t rh = ha*hb, rm0 = ha*lb, rm1 = hb*la, rl = la*lb;
+	uint64_t t = rl + (rm0 << 32);
+	uint64_t c = t < rl;
+	uint64_t lo = t + (rm1 << 32);
+	c += lo < t;
+	*a = lo;
+	*b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+/** Fold the 128-bit product of two 64-bit numbers into 64 bits */
+static inline uint64_t tblMix(uint64_t a, uint64_t b) {
+	tblMum(&a, &b);
+	return a ^ b;
+}
+
+/** Read 8 (possibly unaligned) bytes as a number */
+static inline uint64_t tblRead8(const unsigned char *p) {
+	uint64_t v;
+	memcpy(&v, p, 8);
+	return v;
+}
+
+/** Read 4 (possibly unaligned) bytes as a number */
+static inline uint64_t tblRead4(const unsigned char *p) {
+	uint32_t v;
+	memcpy(&v, p, 4);
+	return v;
+}
+
+/** Calculate the hash for a sequence of bytes (used by symbols), keyed by seed.
+ * Every byte counts, so long strings that differ anywhere (such as URLs sharing a long prefix)
+ * still hash apart. It follows wyhash (public domain): 16 bytes at a time are folded into
+ * the running hash using 64x64->128-bit multiplies, with three independent lanes for long strings. */
 AuintIdx tblCalcStrHash(const char *str, Auint len, AuintIdx seed) {
-	AuintIdx hash = seed ^ (AuintIdx) len;
-	Auint l1;
-	Auint step = (len >> AVM_STRHASHLIMIT) + 1;
-	for (l1 = len; l1 >= step; l1 -= step)
-		hash = hash ^ ((hash<<5) + (hash>>2) + str[l1 - 1]);
-	return hash;
+	static const uint64_t secret[4] = {0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull};
+	const unsigned char *p = (const unsigned char *) str;
+	uint64_t hash = seed ^ tblMix(seed ^ secret[0], secret[1]);
+	uint64_t a, b;
+	if (len <= 16) {
+		if (len >= 4) {
+			a = (tblRead4(p) << 32) | tblRead4(p + ((len>>3)<<2));
+			b = (tblRead4(p + len - 4) << 32) | tblRead4(p + len - 4 - ((len>>3)<<2));
+		}
+		else if (len > 0) {
+			a = ((uint64_t) p[0] << 16) | ((uint64_t) p[len>>1] << 8) | p[len-1];
+			b = 0;
+		}
+		else
+			a = b = 0;
+	}
+	else {
+		Auint i = len;
+		if (i > 48) {
+			uint64_t see1 = hash, see2 = hash;
+			do {
+				hash = tblMix(tblRead8(p) ^ secret[1], tblRead8(p+8) ^ hash);
+				see1 = tblMix(tblRead8(p+16) ^ secret[2], tblRead8(p+24) ^ see1);
+				see2 = tblMix(tblRead8(p+32) ^ secret[3], tblRead8(p+40) ^ see2);
+				p += 48;
+				i -= 48;
+			} while (i > 48);
+			hash ^= see1 ^ see2;
+		}
+		while (i > 16) {
+			hash = tblMix(tblRead8(p) ^ secret[1], tblRead8(p+8) ^ hash);
+			p += 16;
+			i -= 16;
+		}
+		a = tblRead8(p + i - 16);
+		b = tblRead8(p + i - 8);
+	}
+	a ^= secret[1];
+	b ^= hash;
+	tblMum(&a, &b);
+	hash = tblMix(a ^ secret[0] ^ len, b ^ secret[1]);
+	return (AuintIdx) (hash ^ (hash >> 32));
+}
+
+/** Create a shape that adds key to parent (NULL parent for the root) */
+Shape *tblShapeNew(Value th, Shape *parent, Value key) {
+	Shape *s = (Shape*) mem_gcrealloc(th, NULL, 0, sizeof(Shape));
+	s->parent = parent;
+	s->trans = NULL;
+	s->ntrans = s->availtrans = 0;
+	s->nkeys = parent? parent->nkeys+1 : 0;
+	s->keys = s->nkeys? (Value*) mem_gcreallocv(th, NULL, 0, s->nkeys, sizeof(Value)) : NULL;
+	if (parent) {
+		if (parent->nkeys) // The root's keys are NULL
+			memcpy(s->keys, parent->keys, parent->nkeys*sizeof(Value));
+		s->keys[parent->nkeys] = key;
+	}
+	vm(th)->nbrshapes++;
+	return s;
+}
+
+/* Create the VM's root (empty) shape */
+void tblShapeInit(Value th) {
+	vm(th)->nbrshapes = 0;
+	vm(th)->rootshape = tblShapeNew(th, NULL, aNull);
+}
+
+/** Free a shape and all shapes transitioned to from it */
+void tblShapeFreeR(Value th, Shape *s) {
+	for (AuintIdx i=0; i<s->ntrans; i++)
+		tblShapeFreeR(th, s->trans[i]);
+	if (s->trans)
+		mem_freearray(th, s->trans, s->availtrans);
+	if (s->keys)
+		mem_freearray(th, s->keys, s->nkeys);
+	mem_free(th, s);
+}
+
+/* Free all the VM's shapes */
+void tblShapeFree(Value th) {
+	tblShapeFreeR(th, vm(th)->rootshape);
+	vm(th)->rootshape = NULL;
+}
+
+/** Return the shape that adds key to shape s, following its cached transition
+ * or else making a new one. Returns NULL if the VM has no room for more shapes. */
+Shape *tblShapeAdd(Value th, Shape *s, Value key) {
+	for (AuintIdx i=0; i<s->ntrans; i++)
+		if (s->trans[i]->keys[s->nkeys] == key)
+			return s->trans[i];
+	if (vm(th)->nbrshapes >= AVM_SHAPEMAX)
+		return NULL;
+	mem_growvector(th, s->trans, s->ntrans, s->availtrans, Shape*, INT_MAX);
+	return s->trans[s->ntrans++] = tblShapeNew(th, s, key);
+}
+
+/** Set slot to the one holding key's value in a shaped table, or to -1 if not found */
+#define tblShapeSlot(t, key, slot) \
+	{Value *keyp = (t)->shape->keys; \
+	for (slot = (AintIdx)(t)->shape->nkeys-1; slot >= 0 && keyp[slot] != (key); slot--);}
+
+/** Allocate a shaped table's slots, with room for 'size' values (rounded up to a power of 2) */
+void tblAllocslots(Value th, TblInfo *t, AuintIdx size) {
+	t->lAvailNodes = ceillog2(size? size : 1);
+	t->slots = (Value*) mem_gcreallocv(th, NULL, 0, 1<<t->lAvailNodes, sizeof(Value));
+	t->lastfree = NULL;
+	t->shape = vm(th)->rootshape;
+}
+
+#ifdef AVM_SWISSTABLE
+// ***********
+// Swiss-table engine: the index is an open-addressed array of key/value entries,
+// with a parallel array of one-byte control tags. A used entry's tag holds 7 bits of its key's hash;
+// empty and deleted (tombstone) entries have negative tags. Tags are probed in aligned groups of 16
+// using SSE2: a lookup starts at the group picked by the rest of the hash, checks every tag in
+// the group at once, and only moves on (triangularly) when the group has no empty entry.
+// An index of fewer than 16 entries is a single group, padded out with sentinel tags.
+// ***********
+
+#define TblGroup 16		//!< Number of control tags probed at once
+#define CtrlEmpty ((signed char) -128)	//!< Control tag for an entry never used since the index was built
+#define CtrlDeleted ((signed char) -2)	//!< Control tag for a removed entry that probing must pass over
+#define CtrlSentinel ((signed char) -1)	//!< Control tag padding a small index out to a full group
+
+/** The control tags of an index with no entries (size of 0) */
+static const signed char emptyCtrl[TblGroup] = {
+	CtrlEmpty, CtrlEmpty, CtrlEmpty, CtrlEmpty, CtrlEmpty, CtrlEmpty, CtrlEmpty, CtrlEmpty,
+	CtrlEmpty, CtrlEmpty, CtrlEmpty, CtrlEmpty, CtrlEmpty, CtrlEmpty, CtrlEmpty, CtrlEmpty
+};
+
+/** Number of control tags allocated for an index of cap entries */
+#define tblCtrlSize(cap) ((cap)<TblGroup? TblGroup : (cap))
+
+/** Most entries an index of cap entries may use before it is rebuilt (keeping at least one empty) */
+#define tblMaxLoad(cap) ((cap)<8? (cap)-1 : (cap)-((cap)>>3))
+
+/** Mask for the group number of a table's index */
+#define tblGroupMask(t) ((((AuintIdx)1<<(t)->lAvailNodes)>>4)? (((AuintIdx)1<<(t)->lAvailNodes)>>4)-1 : 0)
+
+/** Load the 16 control tags of the group starting at ctrl */
+#define tblGroupLoad(ctrl) _mm_loadu_si128((const __m128i*)(ctrl))
+
+/** Bit mask of the tags in a loaded group equal to tag */
+#define tblGroupMatch(grp, tag) ((unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(grp, _mm_set1_epi8(tag))))
+
+/** Bit mask of the empty or deleted tags in a loaded group (the only tags below the sentinel) */
+#define tblGroupFree(grp) ((unsigned) _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(CtrlSentinel), grp)))
+
+#ifdef _MSC_VER
+/** Position of the lowest set bit in a non-zero group mask */
+static inline unsigned tblCtz(unsigned mask) {
+	unsigned long pos;
+	_BitScanForward(&pos, mask);
+	return pos;
+}
+#else
+/** Position of the lowest set bit in a non-zero group mask */
+#define tblCtz(mask) ((unsigned) __builtin_ctz(mask))
+#endif
+
+/** Hash a key, mixing its bits so that the bottom 7 (the tag) and the rest (the group)
+ * are both well spread, even for pointers and floats whose bottom bits are often 0's.
+ * Symbols (and Text in a TextKeyTbl) start from their contents' hash, other values from the value itself. */
+static inline Auint tblHashKey(TblInfo *t, Value key) {
+	Auint hash = isEnc(key, SymEnc)? (Auint) sym_info(key)->hash
+		: tblIsTextKey(t, key)? (Auint) str_seedhash(key, t->hashseed) : (Auint) key;
+	hash *= (Auint) 0x9E3779B97F4A7C15ull;
+	return hash ^ (hash >> 32);
+}
+
+/** Allocate an empty index of 2^logsize entries, with its control tags */
+void tblAllocindex(Value th, TblInfo *t, unsigned char logsize) {
+	AuintIdx cap = 1 << logsize;
+	t->entries = (TblEntry*) mem_gcreallocv(th, NULL, 0, cap, sizeof(TblEntry));
+	t->ctrl = (signed char*) mem_gcrealloc(th, NULL, 0, tblCtrlSize(cap));
+	memset(t->ctrl, CtrlEmpty, cap);
+	memset(t->ctrl+cap, CtrlSentinel, tblCtrlSize(cap)-cap);
+	t->lAvailNodes = logsize;
+	t->growth = tblMaxLoad(cap);
+}
+
+/** Allocate and initialize table's index with room for 'size' entries.
+ * The number of entries is the smallest power of two that holds 'size' without
+ * exceeding the maximum load. A size of zero means nothing is allocated. */
+void tblAllocnodes(Value th, TblInfo *t, AuintIdx size) {
+	if (size == 0) {
+		t->entries = NULL;
+		t->ctrl = (signed char*) emptyCtrl;
+		t->lAvailNodes = 0;
+		t->growth = 0;
+		return;
+	}
+	unsigned char logsize = 1;
+	while (tblMaxLoad((AuintIdx)1<<logsize) < size)
+		logsize++;
+	tblAllocindex(th, t, logsize);
+}
+
+/** Find the entry containing the key, if it exists, or return NULL */
+TblEntry *tblFind(TblInfo *t, Value key) {
+	Auint hash = tblHashKey(t, key);
+	char tag = (char) (hash & 0x7F);
+	AuintIdx gmask = tblGroupMask(t);
+	AuintIdx group = (AuintIdx) (hash >> 7) & gmask;
+	for (AuintIdx step = 1; ; step++) {
+		__m128i grp = tblGroupLoad(&t->ctrl[group*TblGroup]);
+		for (unsigned mask = tblGroupMatch(grp, tag); mask; mask &= mask-1) {
+			TblEntry *e = &t->entries[group*TblGroup + tblCtz(mask)];
+			if (tblKeyEq(t, key, e->key))
+				return e;
+		}
+		// An empty entry in the group means the key was never placed further on
+		if (tblGroupMatch(grp, CtrlEmpty))
+			return NULL;
+		group = (group + step) & gmask;
+	}
 }
 
+/** Return a pointer to the value in a dictionary-mode table at key, or NULL if not found */
+static inline Value *tblDictGetp(TblInfo *t, Value key) {
+	TblEntry *e = tblFind(t, key);
+	return e? &e->val : NULL;
+}
+
+/** Place a new key/value pair in the first empty or deleted entry on the key's probe sequence.
+ * The caller ensures the index has room (growth) for it. */
+void tblInsert(TblInfo *t, Value key, Value val) {
+	Auint hash = tblHashKey(t, key);
+	AuintIdx gmask = tblGroupMask(t);
+	AuintIdx group = (AuintIdx) (hash >> 7) & gmask;
+	unsigned mask;
+	for (AuintIdx step = 1; !(mask = tblGroupFree(tblGroupLoad(&t->ctrl[group*TblGroup]))); step++)
+		group = (group + step) & gmask;
+	AuintIdx pos = group*TblGroup + tblCtz(mask);
+
+	// Re-using a deleted entry does not use up any growth
+	if (t->ctrl[pos] == CtrlEmpty)
+		t->growth--;
+	t->ctrl[pos] = (signed char) (hash & 0x7F);
+	t->entries[pos].key = key;
+	t->entries[pos].val = val;
+	t->size++;
+}
+
+/** Insert a *new* key into a dictionary-mode table. Once the index has no more room,
+ * the table's parts are resized first (dropping any deleted entries), see tblRehash. */
+void tblDictAdd(Value th, Value tbl, Value key, Value val) {
+	if (tbl_info(tbl)->growth == 0) {
+		tblRehash(th, tbl, key);
+		return tblAdd(th, tbl, key, val);  // insert key into resized table (maybe its array part)
+	}
+	tblInsert(tbl_info(tbl), key, val);
+}
+
+/** Delete a key from a dictionary-mode table. Return 1 if it was there, else 0.
+ * If the entry's group still has an empty entry, no probe ever went past the group,
+ * so the entry can be emptied. Otherwise, it is left as a deleted tombstone. */
+int tblDictRemove(Value th, Value tbl, Value key) {
+	TblInfo *t = tbl_info(tbl);
+	TblEntry *e = tblFind(t, key);
+	if (e == NULL)
+		return 0;
+	AuintIdx pos = e - t->entries;
+	if (tblGroupMatch(tblGroupLoad(&t->ctrl[pos & ~(AuintIdx)(TblGroup-1)]), CtrlEmpty)) {
+		t->ctrl[pos] = CtrlEmpty;
+		t->growth++;
+	}
+	else
+		t->ctrl[pos] = CtrlDeleted;
+	e->key = aNull;
+	e->val = aNull;
+	t->size--;
+	return 1;
+}
+
+/** Position just after key's entry in a dictionary-mode table (for tblIterate), or 0 if not found */
+AuintIdx tblDictPos(TblInfo *t, Value key) {
+	TblEntry *e = tblFind(t, key);
+	return e? (AuintIdx) (e - t->entries) + 1 : 0;
+}
+
+/** tblIterate for a dictionary-mode table */
+AuintIdx tblDictIterate(TblInfo *t, AuintIdx pos, Value *key, Value *val) {
+	AuintIdx cap = 1 << t->lAvailNodes;
+	for (; pos < cap; pos++) {
+		if (t->ctrl[pos] >= 0) {
+			*key = t->entries[pos].key;
+			*val = t->entries[pos].val;
+			return pos+1;
+		}
+	}
+	return 0;
+}
+
+/** Free a dictionary-mode table's index */
+void tblDictFree(Value th, TblInfo *t) {
+	if (t->ctrl != emptyCtrl) {
+		AuintIdx cap = 1 << t->lAvailNodes;
+		mem_freearray(th, t->entries, cap);
+		mem_gcrealloc(th, t->ctrl, tblCtrlSize(cap), 0);
+	}
+}
+
+#else
+// ***********
+// Chained scatter table engine
+// ***********
+
+/** An empty Nodes structure, when a table's index has no entries (size of 0) */
+const struct Node emptyNode = {
+	aNull,
+	aNull,
+	NULL
+};
+
 /** Fast power-of-two calculation from hash to entry in table's index.
  *  Essentially uses just the proper bottom bits. Used for symbols, integers & bool */
 #define hash2NodeMod2(hash, size) \
@@ -94,60 +452,55 @@ Node *tblKey2Node(Value tbl, Value key) {
 
 	// Handle ValPtr allocated values
 	default:
-		// Symbols use the pre-calculated hash
+		// Symbols use the pre-calculated hash, as does Text in a TextKeyTbl
 		if (isSym(key))
 			return &t->nodes[hash2NodeMod2(sym_info(key)->hash, size)];
+		if (tblIsTextKey(t, key))
+			return &t->nodes[hash2NodeMod2(str_seedhash(key, t->hashseed), size)];
 		// Other pointers, the value is the hash
 		return &t->nodes[hash2NodeDiv(key, size)];
 	}
 }
 
-/** Find the node containing the key, if it exists, or return NULL */
+/** Find the node containing the key, if it exists, or return NULL (dictionary mode only) */
 Node *tblFind(Value tbl, Value key) {
-	assert(isTbl(tbl) && key!=aNull);
+	assert(isTbl(tbl) && key!=aNull && !tbl_info(tbl)->shape);
 
 	// Look for the 'key' in the linked chain
+	TblInfo *t = tbl_info(tbl);
 	Node *n = tblKey2Node(tbl, key);
 	do {
-		if (n->key == key)
+		if (tblKeyEq(t, key, n->key))
 			return n;  // Found it
 		n = n->next;
 	} while (n);
 	return NULL;
 }
 
-/* Return a pointer to the value in the table at key, or NULL if not found. */
-Value *tblGetp(Value tbl, Value key) {
-	if (!isTbl(tbl) || key==aNull)
-		return NULL;
+/** Return a pointer to the value in a dictionary-mode table at key, or NULL if not found */
+Value *tblDictGetp(TblInfo *t, Value key) {
+	Node *n = tblFind((Value) t, key);
+	return n? &n->val : NULL;
+}
 
-	// Look for the 'key' in the linked chain
-	Node *n = tblKey2Node(tbl, key);
-	do {
-		if (n->key == key)
-			return &n->val;  // Found it
-		n = n->next;
-	} while (n);
-	return NULL;
+/** Position just after key's node in a dictionary-mode table (for tblIterate), or 0 if not found */
+AuintIdx tblDictPos(TblInfo *t, Value key) {
+	Node *n = tblFind((Value) t, key);
+	return n? (AuintIdx) (n - t->nodes) + 1 : 0;
 }
 
-/* Get the next sequential key/value pair in table after 'key'.
- * To sequentially traverse the table, start with 'key' of 'null'.
- * Each time called, the next key/value pair is returned.
- * After the last key, null is returned.
- * Warning: Accurate traversal requires the table remains unchanged.
-*/
-Value tblNext(Value tbl, Value key) {
-	assert(isTbl(tbl));
-	// Find node for old key, or start of nodes (backtracked)
-	Node *n = (key==aNull)? (tbl_info(tbl)->nodes-1) : tblFind(tbl, key);
-	Node *last = &tbl_info(tbl)->nodes[1 << tbl_info(tbl)->lAvailNodes];
-	if (n) {
-		for (n++; n < last; n++)  
-			if (n->key != aNull)
-				return n->key;
+/** tblIterate for a dictionary-mode table */
+AuintIdx tblDictIterate(TblInfo *t, AuintIdx pos, Value *key, Value *val) {
+	AuintIdx size = 1 << t->lAvailNodes;
+	for (; pos < size; pos++) {
+		Node *n = &t->nodes[pos];
+		if (n->key != aNull) {
+			*key = n->key;
+			*val = n->val;
+			return pos+1;
+		}
 	}
-	return aNull;
+	return 0;
 }
 
 /** Return last table node with a 'null' key, else return NULL. */
@@ -163,9 +516,9 @@ Node *tblLastFreeNode(TblInfo* t) {
 	return NULL;  // could not find a free place
 }
 
-/** Insert a *new* key into a hash table, growing table if necessary.
+/** Insert a *new* key into a dictionary-mode table, growing table if necessary.
  * Do not use this function if key is already in the table. */
-void tblAdd(Value th, Value tbl, Value key, Value val) {
+void tblDictAdd(Value th, Value tbl, Value key, Value val) {
 	Node *mp; // main position node for new key/value pair
 	assert(isTbl(tbl) && key!=aNull);
 
@@ -175,8 +528,8 @@ void tblAdd(Value th, Value tbl, Value key, Value val) {
 		Node *othern;
 		Node *n = tblLastFreeNode(tbl_info(tbl));  /* get a free place */
 		if (n == NULL) {  // cannot find a free place?
-			tblResize(th, tbl, (1<<tbl_info(tbl)->lAvailNodes) + 1);  // grow table
-			return tblAdd(th, tbl, key, val);  // insert key into grown table
+			tblRehash(th, tbl, key);  // grow table
+			return tblAdd(th, tbl, key, val);  // insert key into grown table (maybe its array part)
 		}
 		assert(tbl_info(tbl)->nodes != &emptyNode);
 
@@ -203,24 +556,46 @@ void tblAdd(Value th, Value tbl, Value key, Value val) {
 	tbl_info(tbl)->size++;
 }
 
-/* Delete a key from hash table, if found. 
+/** Allocate and initialize table's index containing 'size' nodes.
+ * The table's node pointer will point to the newly allocated node vector,
+ * which is initialized with 'null' values for all keys and values.
+ * Sizes are increased to next power of two. A size of zero means nothing is allocated. */
+void tblAllocnodes(Value th, TblInfo *t, AuintIdx size) {
+	unsigned char logsize;
+	// If empty, just point to 'emptynode'
+	if (size == 0) {  
+		t->nodes = (Node*) &emptyNode;
+		logsize = 0;
+	}
+	else {
+		AuintIdx i;
+		// Convert size to the next highest power of two
+		logsize = ceillog2(size);
+		size = 1 << logsize;  // 2^logsize
+
+		// Allocate new nodes buffer and initialize with empty nodes
+		t->nodes = (Node*) mem_gcreallocv(th, NULL, 0, size, sizeof(Node));
+		for (i=0; i<size; i++) {
+			memcpy((char *) &t->nodes[i], (char*) &emptyNode, sizeof(Node));
+		}
+	}
+	t->lAvailNodes = logsize;
+	t->lastfree = &t->nodes[size];  // all positions are free 
+}
+
+/** Delete a key from a dictionary-mode table. Return 1 if it was there, else 0.
  * Deletion is fortunately rare, as it is a bit slower and involved because
  * we have to clean up any post-chained nodes by reinserting them into the table.
  * If we don't do this, the empty nodes accumulate unused.
  * This could shrink the table, if we want to ... */
-void tblRemove(Value th, Value tbl, Value key) {
-	assert(isTbl(tbl));
+int tblDictRemove(Value th, Value tbl, Value key) {
 	Value val;
 
-	// Null is never a key
-	if (key==aNull)
-		return;
-
 	// Find the 'key' in the linked chain
 	Node *prevp = NULL; // previous node that chains to key's node
 	Node *n = tblKey2Node(tbl, key);
 	do {
-		if (n->key == key)
+		if (tblKeyEq(tbl_info(tbl), key, n->key))
 			break;
 		prevp = n;
 		n = n->next;
@@ -228,7 +603,7 @@ void tblRemove(Value th, Value tbl, Value key) {
 
 	// Return if key does not exist to delete
 	if (n==NULL)
-		return;
+		return 0;
 
 	// Zero out the node (and break chain to it)
 	if (prevp)
@@ -268,65 +643,305 @@ void tblRemove(Value th, Value tbl, Value key) {
 
 		// Add the node back (possibly into the same spot, alas)
 		tbl_info(tbl)->size--; // Add will re-increment
-		tblAdd(th, tbl, key, val);
+		tblDictAdd(th, tbl, key, val);
 	}
+	return 1;
 }
 
-/** Allocate and initialize table's index containing 'size' nodes.
- * The table's node pointer will point to the newly allocated node vector,
- * which is initialized with 'null' values for all keys and values.
- * Sizes are increased to next power of two. A size of zero means nothing is allocated. */
-void tblAllocnodes(Value th, TblInfo *t, AuintIdx size) {
-	unsigned char logsize;
-	// If empty, just point to 'emptynode'
-	if (size == 0) {  
-		t->nodes = (Node*) &emptyNode;
-		logsize = 0;
+/** Free a dictionary-mode table's index */
+void tblDictFree(Value th, TblInfo *t) {
+	if (t->nodes != &emptyNode)
+		mem_freearray(th, t->nodes, 1<<t->lAvailNodes);
+}
+
+#endif
+
+/* Move a shaped table's keys and values into a hashed index (dictionary mode), for good */
+void tblDictMode(Value th, Value tbl) {
+	TblInfo *t = tbl_info(tbl);
+	Shape *shape = t->shape;
+	Value *slots = t->slots;
+	AuintIdx availslots = 1<<t->lAvailNodes;
+	assert(shape);
+
+	// With room for every key (and one more), no add will resize (or run the GC)
+	t->shape = NULL;
+	tblAllocnodes(th, t, shape->nkeys+1);
+	t->size = 0;
+	for (AuintIdx i=0; i<shape->nkeys; i++)
+		tblDictAdd(th, tbl, shape->keys[i], slots[i]);
+	mem_freearray(th, slots, availslots);
+}
+
+/* Return a pointer to the value in the table at key, or NULL if not found. */
+Value *tblGetp(Value tbl, Value key) {
+	if (!isTbl(tbl) || key==aNull)
+		return NULL;
+
+	// Shaped: look for the key's slot
+	TblInfo *t = tbl_info(tbl);
+	if (t->shape) {
+		AintIdx slot;
+		tblShapeSlot(t, key, slot);
+		return slot<0? NULL : &t->slots[slot];
 	}
-	else {
-		AuintIdx i;
-		// Convert size to the next highest power of two
-		logsize = ceillog2(size);
-		size = 1 << logsize;  // 2^logsize
 
-		// Allocate new nodes buffer and initialize with empty nodes
-		t->nodes = (Node*) mem_gcreallocv(th, NULL, 0, size, sizeof(Node));
-		for (i=0; i<size; i++) {
-			memcpy((char *) &t->nodes[i], (char*) &emptyNode, sizeof(Node));
+	// Integer keys in range are found in the array part
+	if (isInt(key) && (Auint)toAint(key) < t->arraysize) {
+		Value *valp = &t->array[toAint(key)];
+		return *valp==aNoVal? NULL : valp;
+	}
+	return tblDictGetp(t, key);
+}
+
+/** Find the table's first used node at or after position pos (start at 0),
+ * placing its key and value in *key and *val. Return the position to continue from,
+ * or 0 when no nodes are left. Like tblNext, but without looking up the prior key. */
+AuintIdx tblIterate(Value tbl, AuintIdx pos, Value *key, Value *val) {
+	assert(isTbl(tbl));
+	TblInfo *t = tbl_info(tbl);
+	if (t->shape) {
+		if (pos >= t->shape->nkeys)
+			return 0;
+		*key = t->shape->keys[pos];
+		*val = t->slots[pos];
+		return pos+1;
+	}
+
+	// The array part's positions come first, then the hashed index's
+	for (; pos < t->arraysize; pos++) {
+		if (t->array[pos] != aNoVal) {
+			*key = anInt(pos);
+			*val = t->array[pos];
+			return pos+1;
 		}
 	}
-	t->lAvailNodes = logsize;
-	t->lastfree = &t->nodes[size];  // all positions are free 
+	pos = tblDictIterate(t, pos - t->arraysize, key, val);
+	return pos? pos + t->arraysize : 0;
 }
 
-/* Resize a table for more/fewer elements (cannot be smaller than used size)
- * This allocates a new node array, inserts key/value pairs
- * from the old node array, then frees the old node array.
+/* Get the next sequential key/value pair in table after 'key'.
+ * To sequentially traverse the table, start with 'key' of 'null'.
+ * Each time called, the next key/value pair is returned.
+ * After the last key, null is returned.
+ * Warning: Accurate traversal requires the table remains unchanged.
 */
-void tblResize(Value th, Value tbl, AuintIdx newsize) {
-	Node *nodep;
-	TblInfo *t = tbl_info(tbl);
+Value tblNext(Value tbl, Value key) {
 	assert(isTbl(tbl));
+	TblInfo *t = tbl_info(tbl);
+	Value val;
+
+	// Continue iterating from just after the old key (shaped keys are in slot order)
+	AuintIdx pos = 0;
+	if (key!=aNull) {
+		if (t->shape) {
+			AintIdx slot;
+			tblShapeSlot(t, key, slot);
+			pos = (AuintIdx) (slot+1);
+		}
+		else if (isInt(key) && (Auint)toAint(key) < t->arraysize)
+			pos = t->array[toAint(key)]==aNoVal? 0 : (AuintIdx) toAint(key) + 1;
+		else if ((pos = tblDictPos(t, key)))
+			pos += t->arraysize;
+		if (pos == 0)
+			return aNull;
+	}
+	return tblIterate(tbl, pos, &key, &val)? key : aNull;
+}
+
+/** Insert a *new* key into a hash table, growing table if necessary.
+ * Do not use this function if key is already in the table. */
+void tblAdd(Value th, Value tbl, Value key, Value val) {
+	assert(isTbl(tbl) && key!=aNull);
+
+	// Shaped: move to the shape with this key added, putting its value in the next slot.
+	// If the key cannot be shaped, switch to dictionary mode
+	TblInfo *t = tbl_info(tbl);
+	if (t->shape) {
+		Shape *next = (isSym(key) && t->shape->nkeys < AVM_SHAPEMAXKEYS)? tblShapeAdd(th, t->shape, key) : NULL;
+		if (next) {
+			AuintIdx slot = t->shape->nkeys;
+			if (slot == (AuintIdx)1<<t->lAvailNodes) {
+				t->slots = (Value*) mem_gcreallocv(th, t->slots, slot, slot<<1, sizeof(Value));
+				t->lAvailNodes++;
+			}
+			t->slots[slot] = val;
+			t->shape = next;
+			t->size++;
+			return;
+		}
+		tblDictMode(th, tbl);
+	}
+
+	// Integer keys in range go into the array part
+	if (isInt(key) && (Auint)toAint(key) < t->arraysize) {
+		t->array[toAint(key)] = val;
+		t->size++;
+		return;
+	}
+	tblDictAdd(th, tbl, key, val);
+}
+
+/** Rebuild a table's parts: an array part of 'arraysize' values and a hashed index
+ * with room for 'hashsize' entries, moving every key/value pair to where it now belongs */
+void tblResizeParts(Value th, Value tbl, AuintIdx arraysize, AuintIdx hashsize) {
+	TblInfo *t = tbl_info(tbl);
 	mem_gccheck(th);	// Incremental GC before memory allocation events
 
-	// Preserve pointer to old index, then allocate a new one
-	AuintIdx oldsize = 1 << t->lAvailNodes; // 2^
-	if (newsize < oldsize)
-		newsize = oldsize;
-	Node *oldnodes = t->nodes;  // save old index
-	tblAllocnodes(th, t, newsize);
+	// Preserve old parts (in a copy of the table's info), then allocate new ones
+	TblInfo old = *t;
+	tblAllocnodes(th, t, hashsize);
+	t->array = arraysize? (Value*) mem_gcreallocv(th, NULL, 0, arraysize, sizeof(Value)) : NULL;
+	for (AuintIdx i=0; i<arraysize; i++)
+		t->array[i] = aNoVal;
+	t->arraysize = arraysize;
 	t->size = 0; // Will recount entries as we re-add
 
-	// re-insert elements from old index
-	for (nodep = &oldnodes[oldsize - 1]; nodep >= oldnodes; nodep--) {
-		if (nodep->key != aNull) {
-			tblAdd(th, tbl, nodep->key, nodep->val);
+	// re-insert elements from old parts, then free them
+	AuintIdx pos = 0;
+	Value key, val;
+	while ((pos = tblIterate((Value) &old, pos, &key, &val)))
+		tblAdd(th, tbl, key, val);
+	tblDictFree(th, &old);
+	if (old.array)
+		mem_freearray(th, old.array, old.arraysize);
+}
+
+/** Most log2 of the size of a table's array part */
+#define TblMaxArrayBits 26
+
+/** Count an Integer key that could go into an array part, by its log2 slice */
+static inline void tblCountInt(Value key, AuintIdx *nums, AuintIdx *nints) {
+	if (isInt(key) && toAint(key) >= 0 && toAint(key) < ((Aint)1<<TblMaxArrayBits)) {
+		nums[ceillog2((AuintIdx)toAint(key)+1)]++;
+		(*nints)++;
+	}
+}
+
+/* Resize a table's parts to make room for a new key, once its hashed index is full (as Lua does).
+ * The array part becomes the largest power of 2 (n) such that more than n/2 of the Integer
+ * keys 0 to n-1 would be in use. The hashed index gets room for all other keys. */
+void tblRehash(Value th, Value tbl, Value key) {
+	AuintIdx nums[TblMaxArrayBits+1]; // nums[i] is number of Integer keys k, 2^(i-1) <= k < 2^i
+	AuintIdx nints = 0;
+	AuintIdx nkeys = 1;
+	memset(nums, 0, sizeof(nums));
+
+	// Count Integer keys, in both parts and the new key
+	AuintIdx pos = 0;
+	Value k, v;
+	tblCountInt(key, nums, &nints);
+	while ((pos = tblIterate(tbl, pos, &k, &v))) {
+		nkeys++;
+		tblCountInt(k, nums, &nints);
+	}
+
+	// Find the array part size that is more than half used
+	AuintIdx arraysize = 0;
+	AuintIdx narray = 0;
+	AuintIdx a = 0;
+	for (int i=0; i<=TblMaxArrayBits && ((AuintIdx)1<<i)/2 < nints; i++) {
+		a += nums[i];
+		if (a > ((AuintIdx)1<<i)/2) {
+			arraysize = (AuintIdx)1<<i;
+			narray = a;
 		}
 	}
+	tblResizeParts(th, tbl, arraysize, nkeys - narray);
+}
 
-	// free old index
-	if (oldnodes != &emptyNode)
-		mem_gcrealloc(th, oldnodes, oldsize*sizeof(Node), 0); 
+/** Changing the properties of a type that a cached property lookup has searched invalidates
+ * all property caches. Other types, such as an instance's own fields, are never searched
+ * for a cache, so writing them leaves the caches alone. Redefining an Integer or
+ * Float arithmetic/compare method also turns off byte-code's inline handling of those operators,
+ * so that the new method is always called */
+#define tblTypeChanged(th, tbl, key) \
+	if (tbl_info(tbl)->flags1 & TypeTbl) { \
+		if (tbl_info(tbl)->flags1 & CachedTbl) \
+			vm(th)->typeepoch++; \
+		if (vm(th)->fastnumops && (tbl==vmlit(TypeIntm) || tbl==vmlit(TypeFlom)) \
+			&& (key==vmlit(SymPlus) || key==vmlit(SymMinus) || key==vmlit(SymMult) \
+				|| key==vmlit(SymDiv) || key==vmlit(SymRocket))) \
+			vm(th)->fastnumops = 0; \
+	}
+
+/* Delete a key from hash table, if found. */
+void tblRemove(Value th, Value tbl, Value key) {
+	assert(isTbl(tbl));
+
+	// Null is never a key
+	if (key==aNull)
+		return;
+	tblTypeChanged(th, tbl, key);
+
+	// A shaped table must give up its shape to lose a key
+	if (tbl_info(tbl)->shape) {
+		if (!tblGetp(tbl, key))
+			return;
+		tblDictMode(th, tbl);
+	}
+
+	// Integer keys in range are removed from the array part
+	TblInfo *t = tbl_info(tbl);
+	if (isInt(key) && (Auint)toAint(key) < t->arraysize) {
+		if (t->array[toAint(key)] != aNoVal) {
+			t->array[toAint(key)] = aNoVal;
+			t->size--;
+		}
+		return;
+	}
+
+	if (tblDictRemove(th, tbl, key) && t->flags1 & GlobalTbl)
+		gloCellSet(th, key, aNull);
+}
+
+/* Resize a table for more/fewer elements (cannot be smaller than used size) */
+void tblResize(Value th, Value tbl, AuintIdx newsize) {
+	assert(isTbl(tbl));
+	// A shaped table's slots grow as keys are added, up to its shape's limit
+	if (tbl_info(tbl)->shape) {
+		if (newsize <= AVM_SHAPEMAXKEYS)
+			return;
+		tblDictMode(th, tbl);
+	}
+
+	// Keep the array part, giving the hashed index room for at least its own keys
+	TblInfo *t = tbl_info(tbl);
+	AuintIdx hashsize = t->size;
+	for (AuintIdx i=0; i<t->arraysize; i++)
+		if (t->array[i] != aNoVal)
+			hashsize--;
+	tblResizeParts(th, tbl, t->arraysize, newsize > hashsize? newsize : hashsize);
+}
+
+/* Mark all in-use table values for garbage collection */
+void tblMark(Value th, TblInfo *t) {
+	AuintIdx pos = 0;
+	Value key, val;
+	mem_markobj(th, t->type);
+	mem_markobj(th, t->inheritype);
+	while ((pos = tblIterate((Value) t, pos, &key, &val))) {
+		mem_markobj(th, key);
+		mem_markobj(th, val);
+	}
+	if (t->propcache)
+		for (AuintIdx i=0; i<AVM_TYPECACHESIZE; i++) {
+			mem_markobj(th, t->propcache->entry[i].sym);
+			mem_markobj(th, t->propcache->entry[i].val);
+		}
+}
+
+/* Free all of a table's allocated memory */
+void tblFree(Value th, TblInfo *t) {
+	if (t->shape)
+		mem_freearray(th, t->slots, 1<<t->lAvailNodes);
+	else
+		tblDictFree(th, t);
+	if (t->array)
+		mem_freearray(th, t->array, t->arraysize);
+	if (t->propcache)
+		mem_free(th, t->propcache);
+	mem_free(th, t);
 }
 
 /* Create and initialize a new hashed Table */
@@ -336,19 +951,48 @@ Value newTbl(Value th, Value *dest, Value type, AuintIdx size) {
 	t->type = type;
 	t->inheritype = aNull;
 	t->size = 0;
+	t->propcache = NULL;
+	t->shape = NULL;
+	t->array = NULL;
+	t->arraysize = 0;
 
 	tblAllocnodes(th, t, size);
 	return *dest = (Value) t;
 }
 
+/* Create and initialize a new hash table whose Text keys match by content, not identity */
+Value newTextTbl(Value th, Value *dest, Value type, AuintIdx size) {
+	newTbl(th, dest, type, size);
+	tbl_info(*dest)->flags1 |= TextKeyTbl;
+	tbl_info(*dest)->hashseed = vm(th)->hashseed;
+	return *dest;
+}
+
+/* Return true if both keys are Text values with the same contents */
+int tblTextEq(Value key1, Value key2) {
+	if (!isStr(key1) || !isStr(key2))
+		return 0;
+	StrInfo *s1 = str_info(key1);
+	StrInfo *s2 = str_info(key2);
+	return s1->size == s2->size && (s1->hash == 0 || s2->hash == 0 || s1->hash == s2->hash)
+		&& memcmp(s1->str, s2->str, s1->size) == 0;
+}
+
 /* Create and initialize a new Type (a table where members are properties) */
 Value newType(Value th, Value *dest, Value type, AuintIdx size) {
 	TblInfo *t = (TblInfo*) mem_new(th, TblEnc, sizeof(TblInfo));
 	t->flags1 = TypeTbl | ProtoType;
 	t->type = t->inheritype = type;
 	t->size = 0;
+	t->propcache = NULL;
+	t->shape = NULL;
+	t->array = NULL;
+	t->arraysize = 0;
 
-	tblAllocnodes(th, t, size);
+	if (size <= AVM_SHAPEMAXKEYS)
+		tblAllocslots(th, t, size);
+	else
+		tblAllocnodes(th, t, size);
 	return *dest = (Value) t;
 }
 
@@ -359,11 +1003,31 @@ Value newMixin(Value th, Value *dest, Value type, Value inheritype, AuintIdx siz
 	t->type = type;
 	t->inheritype = inheritype;
 	t->size = 0;
+	t->propcache = NULL;
+	t->shape = NULL;
+	t->array = NULL;
+	t->arraysize = 0;
 
 	tblAllocnodes(th, t, size);
 	return *dest = (Value) t;
 }
 
+/* Return the Type's cache of property lookups, allocating it or emptying it (if stale) as needed */
+TypeCache *tblTypeCache(Value th, Value type) {
+	TblInfo *t = tbl_info(type);
+	assert(isType(type));
+	if (t->propcache == NULL) {
+		t->propcache = (TypeCache*) mem_gcrealloc(th, NULL, 0, sizeof(TypeCache));
+		t->propcache->epoch = 0; // Stale, so it is emptied below
+	}
+	if (t->propcache->epoch != vm(th)->typeepoch) {
+		t->propcache->epoch = vm(th)->typeepoch;
+		for (AuintIdx i=0; i<AVM_TYPECACHESIZE; i++)
+			t->propcache->entry[i].sym = t->propcache->entry[i].val = aNull;
+	}
+	return t->propcache;
+}
+
 /* Return 1 if the value is a Table, otherwise 0 */
 int isTbl(Value val) {
 	return isEnc(val, TblEnc);
@@ -388,8 +1052,7 @@ int tblHas(Value th, Value tbl, Value key) {
 		return 0;
 
 	// Find key, and return what we find (or not)
-	Node *n = tblFind(tbl, key);
-	return (n)? 1 : 0;
+	return tblGetp(tbl, key)? 1 : 0;
 }
 
 /* Return the value paired with 'key', or 'null' if not found */
@@ -401,8 +1064,8 @@ Value tblGet(Value th, Value tbl, Value key) {
 		return aNull;
 
 	// Find key, and return what we find (or not)
-	Node *n = tblFind(tbl, key);
-	return (n)? n->val : aNull;
+	Value *valp = tblGetp(tbl, key);
+	return (valp)? *valp : aNull;
 }
 
 /* Inserts or alters the table's 'key' entry with value. 
@@ -414,11 +1077,12 @@ void tblSet(Value th, Value tbl, Value key, Value val) {
 	// Null is never a key
 	if (key==aNull)
 		return;
+	tblTypeChanged(th, tbl, key);
 
 	// Look for key. If found, replace value. Otherwise, insert key/value pair
-	Node *n = tblFind(tbl, key);
-	if (n) {
-		n->val = val;
+	Value *valp = tblGetp(tbl, key);
+	if (valp) {
+		*valp = val;
 		mem_markChk(th, tbl, val);
 	}
 	else {
@@ -426,12 +1090,16 @@ void tblSet(Value th, Value tbl, Value key, Value val) {
 		mem_markChk(th, tbl, key);
 		mem_markChk(th, tbl, val);
 	}
+
+	// Keep any global variable's bound cell coherent
+	if (tbl_info(tbl)->flags1 & GlobalTbl)
+		gloCellSet(th, key, val);
 }
 
 /* Serialize an table's contents to indented text */
 void tblSerialize(Value th, Value str, int indent, Value tbl) {
-	Node *n = tbl_info(tbl)->nodes;
-	Node *last = &tbl_info(tbl)->nodes[1 << tbl_info(tbl)->lAvailNodes];
+	AuintIdx pos = 0;
+	Value key, val;
 	int ind;
 
 	const char *typ = isType(tbl)? "Object" : "Index";
@@ -447,16 +1115,14 @@ void tblSerialize(Value th, Value str, int indent, Value tbl) {
 	// 	strAppend(th, str, "\t", 1);
 	// strAppend(th, str, "TYPE: ", 6);
 	// serialize(th, str, indent+1, getType(th, tbl));
-	for (; n < last; n++) {
-		if (n->key != aNull) {
-			strAppend(th, str, "\n", 1);
-			ind = indent+1;
-			while (ind--)
-				strAppend(th, str, "\t", 1);
-			serialize(th, str, indent+1, n->key);
-			strAppend(th, str, ": ", 2);
-			serialize(th, str, indent+1, n->val);
-		}
+	while ((pos = tblIterate(tbl, pos, &key, &val))) {
+		strAppend(th, str, "\n", 1);
+		ind = indent+1;
+		while (ind--)
+			strAppend(th, str, "\t", 1);
+		serialize(th, str, indent+1, key);
+		strAppend(th, str, ": ", 2);
+		serialize(th, str, indent+1, val);
 	}
 }
 
@@ -21,16 +21,102 @@ Value newThread(Value th, Value *dest, Value method, AuintIdx stksz, char flags)
 	// Create and initialize a thread
 	newth = (ThreadInfo *) mem_newnolink(th, ThrEnc, sizeof(ThreadInfo));
 	*dest = (Value)newth;
+	thrInit(newth, vm(th), method, stksz, flags);
 
-	// Add to the list of threads
+	// Add to the list of threads. Allocating its stacks may have stepped the collector
+	// past its atomic phase, which could not see the thread, so (re)mark it as new.
+	newth->marked = vm(th)->currentwhite & WHITEBITS;
 	MemInfo **list = &vm(th)->threads;
 	((MemInfo*)newth)->next = *list;
 	*list = (MemInfo*)newth;
-
-	thrInit(newth, vm(th), method, stksz, flags);
 	return newth;
 }
 
+/* Return a new stackless yielder. Rather than stacks to run on, it only holds the state
+ * needed to resume its method's frame: the registers saved at its last yield (above the
+ * method, as for other threads) and one call frame for its ip and where the yield's results
+ * go. callStacklessPrep runs that frame on the calling thread, and OpYield saves it back here. */
+Value newStacklessYielder(Value th, Value *dest, Value method) {
+	AuintIdx nregs = ((BMethodInfo*) method)->maxstacksize;
+	ThreadInfo *yielder = (ThreadInfo *) mem_newnolink(th, ThrEnc, sizeof(ThreadInfo));
+	*dest = (Value) yielder;
+	yielder->vm = vm(th);
+	yielder->flags1 = ThreadYielder | ThreadStackless;
+	yielder->yieldTo = aNull;
+
+	// Allocate room for method and its saved registers, then the frame to resume
+	yielder->stack = NULL;
+	mem_reallocvector(th, yielder->stack, 0, nregs + 1, Value);
+	yielder->size = nregs + 1;
+	yielder->stk_last = yielder->stack + yielder->size;
+	for (AuintIdx i = 0; i < yielder->size; i++)
+		yielder->stack[i] = aNull;
+	yielder->stack[0] = method;
+	yielder->stk_top = yielder->stack + 1; // where callMorCPrep puts the parms
+	yielder->calls = NULL;
+	mem_reallocvector(th, yielder->calls, 0, 1, CallInfo);
+	CallInfo *ci = yielder->curmethod = yielder->calls_last = yielder->calls;
+	ci->nresults = 0;
+	ci->methodbase = yielder->stack;
+	ci->begin = ci->retTo = yielder->stk_top;
+	ci->end = ci->begin + nregs;
+	ci->method = method;
+	ci->ip = ((BMethodInfo*) method)->runcode;
+
+	// Add to the list of threads
+	yielder->marked = vm(th)->currentwhite & WHITEBITS;
+	yielder->next = vm(th)->threads;
+	vm(th)->threads = (MemInfo*) yielder;
+	return yielder;
+}
+
+/* Return a new yielder for a byte-code method, whose data stack is sized to what the
+ * method's frame needs. A dead yielder is taken from the VM's pool when there is one,
+ * so a burst of short-lived yielders allocates nothing after the first few. */
+Value newYielder(Value th, Value *dest, Value method) {
+	VmInfo *vm = vm(th);
+	Value meth = isArr(method)? arrGet(th, method, 0) : method;
+	if (methodFlags(meth) & METHOD_FLG_STACKLESS)
+		return newStacklessYielder(th, dest, meth);
+
+	AuintIdx stksz = ((BMethodInfo*) meth)->maxstacksize;
+	if (stksz < STACK_MINSIZE)
+		stksz = STACK_MINSIZE; // entry frame is at least this big
+	stksz += 2*STACK_EXTRA + 2;
+	if (isVarParm(meth))
+		stksz += methodNParms(meth); // fixed parms are copied up above the varargs
+
+	ThreadInfo *yielder = (ThreadInfo*) vm->yielderpool;
+	if (yielder == NULL)
+		return newThread(th, dest, method, stksz, ThreadYielder);
+
+	// Unlink from pool, then reuse its data stack if big enough (clearing old values),
+	// otherwise replace it. The collector cannot see the thread until it is linked in below.
+	vm->yielderpool = yielder->next;
+	vm->yielderpoolsz--;
+	if (yielder->size >= stksz) {
+		for (Value *p = yielder->stack; p < yielder->stack + yielder->size; p++)
+			*p = aNull;
+	}
+	else {
+		mem_freearray(th, yielder->stack, yielder->size);
+		yielder->stack = NULL;
+		yielder->size = 0;
+		stkRealloc(yielder, stksz);
+	}
+
+	yielder->flags1 = ThreadYielder;
+	thrResetCI(yielder, method);
+
+	// Link in again as a new, live thread
+	yielder->marked = vm->currentwhite & WHITEBITS;
+	yielder->next = vm->threads;
+	vm->threads = (MemInfo*) yielder;
+	*dest = (Value) yielder;
+	vm->gcnbrnew++;
+	return yielder;
+}
+
 /* Initialize a thread.
  * We do this separately, as Vm allocates main thread as part of VmInfo */
 void thrInit(ThreadInfo* thr, VmInfo* vm, Value method, AuintIdx stksz, char flags) {
@@ -39,16 +125,21 @@ void thrInit(ThreadInfo* thr, VmInfo* vm, Value method, AuintIdx stksz, char fla
 	thr->size = 0;
 	thr->flags1 = flags;
 
-	// Allocate and initialize thread's stack
+	// Allocate thread's data and call stacks
 	thr->stack = NULL;
 	thr->size = 0;
 	stkRealloc(thr, stksz);
+	thr->calls = NULL;
+	mem_reallocvector(thr, thr->calls, 0, CALLSTACK_NEWSIZE, CallInfo);
+	thr->calls_last = thr->calls + CALLSTACK_NEWSIZE - 1;
+	thrResetCI(thr, method);
+}
+
+/* Empty a thread's stacks, leaving only the entry call frame for its method */
+void thrResetCI(ThreadInfo* thr, Value method) {
 	thr->stk_top = thr->stack;
 	thr->yieldTo = aNull;
-
-	// initialize call stack
-	CallInfo *ci = thr->curmethod = &thr->entrymethod; // Initial callinfo struct is already allocated
-	ci->next = ci->previous = NULL;
+	CallInfo *ci = thr->curmethod = thr->calls;
 	// ci->callstatus = 0;
 	ci->nresults = 0;
 	ci->methodbase = ci->retTo = thr->stk_top;
@@ -60,7 +151,7 @@ void thrInit(ThreadInfo* thr, VmInfo* vm, Value method, AuintIdx stksz, char fla
 	// Use byte-code method's info to set up ip and stack size
 	if (method != aNull) {
 		assert(isMethod(method) && !isCMethod(method));
-		ci->ip = ((BMethodInfo*) method)->code; // Start with first instruction
+		ci->ip = ((BMethodInfo*) method)->runcode; // Start with first instruction
 		needMoreLocal(thr, ((BMethodInfo*) method)->maxstacksize); // Ensure we have enough stack space
 	}
 }
@@ -70,25 +161,17 @@ int isThread(Value th) {
 	return isEnc(th, ThrEnc);
 }
 
-/** Internal routine to allocate and append a new CallInfo structure to end of call stack */
+/* Internal routine to grow the call stack, returning the new current frame just above the old one.
+ * The call stack doubles in size, moving all frames. Anyone holding a CallInfo pointer
+ * across a call must refresh it from curmethod afterwards. */
 CallInfo *thrGrowCI(Value th) {
-	CallInfo *ci = (CallInfo *) mem_gcrealloc(th, NULL, 0, sizeof(CallInfo));
-	assert(th(th)->curmethod->next == NULL);
-	th(th)->curmethod->next = ci;
-	ci->previous = th(th)->curmethod;
-	ci->next = NULL;
-	return ci;
-}
-
-/** Free all allocated CallInfo blocks in thread */
-void thrFreeCI(Value th) {
-	CallInfo *ci = th(th)->curmethod;
-	CallInfo *next = ci->next;
-	ci->next = NULL;
-	while ((ci = next) != NULL) {
-		next = ci->next;
-		mem_free(th, ci);
-	}
+	ThreadInfo *thr = th(th);
+	AuintIdx cur = thr->curmethod - thr->calls;
+	AuintIdx size = thr->calls_last - thr->calls + 1;
+	assert(thr->curmethod == thr->calls_last);
+	mem_reallocvector(th, thr->calls, size, 2*size, CallInfo);
+	thr->calls_last = thr->calls + 2*size - 1;
+	return thr->curmethod = thr->calls + cur + 1;
 }
 
 /* Free everything allocated for thread */
@@ -96,12 +179,38 @@ void thrFreeStacks(Value th) {
 	if (th(th)->stack == NULL)
 		return;  /* stack not completely built yet */
 	// Free call stack
-	th(th)->curmethod = &th(th)->entrymethod;
-	thrFreeCI(th);
+	mem_freearray(th, th(th)->calls, th(th)->calls_last - th(th)->calls + 1);
+	th(th)->curmethod = th(th)->calls = th(th)->calls_last = NULL;
 	// Free data stack
 	mem_freearray(th, th(th)->stack, th(th)->size);  /* free stack array */
 }
 
+/* Keep a dead yielder (and its stacks) in the VM's pool for reuse, rather than freeing it.
+ * Returns false if the thread must be freed instead. */
+bool thrPool(Value th, ThreadInfo *t) {
+	VmInfo *vm = vm(th);
+	if ((t->flags1 & (ThreadYielder | ThreadStackless)) != ThreadYielder || t->stack == NULL
+		|| vm->yielderpoolsz >= YIELDER_POOLSIZE)
+		return false;
+	t->yieldTo = aNull;
+	t->next = vm->yielderpool;
+	vm->yielderpool = (MemInfo*) t;
+	vm->yielderpoolsz++;
+	return true;
+}
+
+/* Free all yielder threads held in the VM's pool */
+void thrFreePool(Value th) {
+	VmInfo *vm = vm(th);
+	while (vm->yielderpool) {
+		ThreadInfo *t = (ThreadInfo*) vm->yielderpool;
+		vm->yielderpool = t->next;
+		thrFreeStacks(t);
+		mem_free(th, t);
+	}
+	vm->yielderpoolsz = 0;
+}
+
 
 /* Retrieve a value from global namespace */
 Value gloGet(Value th, Value var) {
@@ -115,6 +224,29 @@ void gloSet(Value th, Value var, Value val) {
 	tblSet(th, vm(th)->global, var, val);
 }
 
+/* Return the cell bound to a global variable, creating it if needed.
+ * A cell is a two-element array holding the variable's current value and its name.
+ * Byte-code reads a global with a single load from its cell, as the global
+ * table keeps the value in its variables' cells up to date (see tblSet). */
+Value gloCell(Value th, Value var) {
+	Value cell = tblGet(th, vm(th)->globalcells, var);
+	if (cell == aNull) {
+		cell = pushArray(th, aNull, 2);
+		arrSet(th, cell, 0, gloGet(th, var));
+		arrSet(th, cell, 1, var);
+		tblSet(th, vm(th)->globalcells, var, cell);
+		popValue(th);
+	}
+	return cell;
+}
+
+/* Refresh a global variable's bound cell (if it has one) with its new value */
+void gloCellSet(Value th, Value var, Value val) {
+	Value *cell = tblGetp(vm(th)->globalcells, var);
+	if (cell)
+		arrSet(th, *cell, 0, val);
+}
+
 #ifdef __cplusplus
 } // extern "C"
 } // namespace avm
@@ -69,8 +69,10 @@ void setType(Value th, Value val, Value type) {
 		return;
 
 	((MemInfoT*)val)->type = type;
-	if (isTbl(val) && ((TblInfo*)val)->flags1 & ProtoType)
+	if (isTbl(val) && ((TblInfo*)val)->flags1 & ProtoType) {
 		((TblInfo*)val)->inheritype = type;
+		vm(th)->typeepoch++; // Prototype's inheritance changed: property caches are stale
+	}
 	mem_markChk(th, val, type);
 }
 
@@ -80,6 +82,9 @@ void addMixin(Value th, Value val, Value mixin) {
 	if (!isPtr(val) || ((MemInfo*)val)->enctyp < TypedEnc || !isType(mixin))
 		return;
 
+	// Inheritance is changing (perhaps in a type list shared with other values): property caches are stale
+	vm(th)->typeepoch++;
+
 	// Change inheritype for mixins, otherwise change value's type
 	Value type = (isType(val) && !(tbl_info(val)->flags1 & ProtoType))?  tbl_info(val)->inheritype : ((MemInfoT*)val)->type;
 
@@ -184,12 +189,14 @@ void serialize(Value th, Value str, int indent, Value val) {
 	return; // Should not ever get here
 }
 
-/** Find method in part's methods or mixins. Return aNull if not found */
+/** Find method in part's methods or mixins. Return aNull if not found.
+ * Each Type searched is marked CachedTbl, as the result (which caches may keep) depends on it. */
 Value *getPropR(Value type, Value methsym) {
 	Value *meth;
 
 	// If this is a Type table, check its properties
 	if (isType(type)) {
+		tbl_info(type)->flags1 |= CachedTbl;
 		if (NULL != (meth = tblGetp(type, methsym)))
 			return meth;
 		// Or else try inherited properties
@@ -202,6 +209,7 @@ Value *getPropR(Value type, Value methsym) {
 		Value *types = arr_info(type)->arr;
 		AuintIdx ntypes = arr_size(type);
 		while (ntypes--) {
+			tbl_info(*types)->flags1 |= CachedTbl;
 			if (NULL != (meth = tblGetp(*types, methsym)))
 				return meth;
 			// Or else try inherited properties
@@ -224,15 +232,31 @@ Value getProperty(Value th, Value self, Value methsym) {
 			return *meth;
 	}
 
-	// Next, look for the method in the value's type
-	if (NULL != (meth = getPropR(getType(th, self), methsym)))
-		return *meth;
+	// Next, see if the type's cache already knows where (or whether) it is found
+	Value type = getType(th, self);
+	TypeCache *tc = NULL;
+	AuintIdx slot = 0;
+	if (isEnc(methsym, SymEnc) && isType(type)) {
+		tc = tblTypeCache(th, type);
+		slot = sym_info(methsym)->hash & (AVM_TYPECACHESIZE-1);
+		if (tc->entry[slot].sym == methsym)
+			return tc->entry[slot].val;
+	}
 
-	// As a last resort, look for the method in the All type
-	if (NULL != (meth = tblGetp(vmlit(TypeAll), methsym)))
-		return *meth;
+	// Look for the method in the value's type or, as a last resort, in the All type
+	Value val = aNull;
+	if (NULL != (meth = getPropR(type, methsym))
+		|| NULL != (meth = getPropR(vmlit(TypeAll), methsym)))
+		val = *meth;
 
-	return aNull;
+	// Remember it in the type's cache, even when not found
+	if (tc) {
+		tc->entry[slot].sym = methsym;
+		tc->entry[slot].val = val;
+		mem_markChk(th, type, methsym);
+		mem_markChk(th, type, val);
+	}
+	return val;
 }
 
 /* Return the size of a symbol, string, array, hash or other collection. Any other value type returns 0 */
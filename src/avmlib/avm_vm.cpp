@@ -57,6 +57,8 @@ AVM_API Value newVM(void) {
 	((ThreadInfo*) th)->next = NULL;
 	thrInit(&vm->main_thr, vm, aNull, STACK_NEWSIZE, 0);
 	vm->threads = NULL;
+	vm->yielderpool = NULL;
+	vm->yielderpoolsz = 0;
 
 	// Initialize PCG random number generator to starting values
 	vm->pcgrng_state = 0x853c49e6748fea9bULL;
@@ -73,11 +75,19 @@ AVM_API Value newVM(void) {
 	vm->hashseed = tblCalcStrHash(seedstr, sizeof(seedstr), (AuintIdx) timehash);
 
 	// Initialize vm-wide symbol table, global table and literals
+	vm->jitthreshold = AVM_JITTHRESHOLD;
+	vm->typeepoch = 1; // Newly generated property caches start out stale (at 0)
+	tblShapeInit(th); // Root of the shapes used by types and objects
 	sym_init(th); // Initialize hash table for symbols
 	newTbl(th, &vm->global, aNull, GLOBAL_NEWSIZE); // Create global hash table
 	mem_markChk(th, vm, vm->global);
+	newTbl(th, &vm->globalcells, aNull, GLOBAL_NEWSIZE); // Cells bound to global variables
+	mem_markChk(th, vm, vm->globalcells);
+	tbl_info(vm->global)->flags1 |= GlobalTbl;
 	vm_litinit(th); // Load reserved and standard symbols into literal list
+	vm->fastnumops = 0;
 	core_init(th); // Load up global table and literal list with core types
+	vm->fastnumops = 1; // Core operators in place: byte-code may now do Integer/Float arithmetic inline
 	setType(th, vm->global, vmlit(TypeIndexm)); // Fix up type info for global table
 
 	// Initialize byte-code standard methods and the Acorn compiler
@@ -94,10 +104,14 @@ void vmClose(Value th) {
 	th = vm(th)->main_thread;
 	VmInfo* vm = vm(th);
 	mem_freeAll(th);  /* collect all objects */
+	tblShapeFree(th);
 	mem_reallocvector(th, vm->stdsym, nStdSym, 0, Value);
 	sym_free(th);
 	thrFreeStacks(th);
 	assert(vm(th)->totalbytes == sizeof(VmInfo));
+#ifndef AVM_NONURSERY
+	mem_nurseryclose(vm);
+#endif
 	mem_frealloc(vm(th), 0);  /* free main block */
 	logInfo(AVM_RELEASE " ended.");
 }
@@ -134,16 +148,16 @@ float vmEndTimer(int64_t starttime)
 #include <sys/time.h>
 int64_t vmStartTimer()
 {
-	struct time_val start;
+	struct timeval start;
 	gettimeofday(&start, NULL);
 	return start.tv_sec*1000000 + start.tv_usec;
 }
 
 float vmEndTimer(int64_t starttime)
 {
-	struct time_val now;
+	struct timeval now;
 	gettimeofday(&now, NULL);
-	int64_t end = now.tv_sec*1000000 + end.tv_usec;
+	int64_t end = now.tv_sec*1000000 + now.tv_usec;
     return float(end - starttime)/1000000.0f;
 }
 #endif
@@ -20,6 +20,13 @@ int index_new(Value th) {
 	return 1;
 }
 
+/** Create a new TextIndex, whose Text keys match by content */
+int textindex_new(Value th) {
+	Value traits = pushProperty(th, 0, "traits"); popValue(th);
+	pushTextTbl(th, traits, getTop(th)>1 && isInt(getLocal(th,1))? toAint(getLocal(th,1)) : 4);
+	return 1;
+}
+
 /** Return true if index has no elements */
 int index_isempty(Value th) {
 	pushValue(th, tbl_size(getLocal(th, 0))==0? aTrue : aFalse);
@@ -108,6 +115,18 @@ void core_index_init(Value th) {
 		pushCMethod(th, index_new);
 		popProperty(th, 0, "New");
 	popGloVar(th, "Index");
+
+	// A TextIndex is an Index whose Text keys match by content
+	vmlit(TypeTextIndexc) = pushType(th, aNull, 4);
+		pushSym(th, "TextIndex");
+		popProperty(th, 0, "_name");
+		vmlit(TypeTextIndexm) = pushMixin(th, vmlit(TypeObject), vmlit(TypeIndexm), 4);
+			pushSym(th, "*TextIndex");
+			popProperty(th, 1, "_name");
+		popProperty(th, 0, "traits");
+		pushCMethod(th, textindex_new);
+		popProperty(th, 0, "New");
+	popGloVar(th, "TextIndex");
 	return;
 }
 
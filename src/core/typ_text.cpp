@@ -113,11 +113,6 @@ int text_compare(Value th) {
 	return 1;
 }
 
-/** Calculates the number of UTF-8 bytes used to encode the Unicode code point pointed at by textp */
-#define utf8_charsize(textp) \
-	((*textp&0x80) == 0x00? (*textp? 1 : 0) : \
-	(*textp&0xE0) == 0xC0? 2 : (*textp&0xF0) == 0xE0? 3 : 4)
-
 /** Scan entire utf8 string to determine how many unicode code points it has */
 #define utf8_length(lenvar, textp) { \
 	lenvar = 0; \
@@ -25,9 +25,9 @@ int context_reset(Value th) {
 	ThreadInfo *context = (ThreadInfo*) getLocal(th, 0);
 	context->flags1 &= ~(ThreadDone);
 	context->yieldTo = aNull;
-	CallInfo *cf = context->curmethod = &context->entrymethod;
+	CallInfo *cf = context->curmethod = thrEntryCI(context);
 	cf->nresults = 0;
-	cf->ip = ((BMethodInfo*) cf->method)->code; // Start with first instruction
+	cf->ip = ((BMethodInfo*) cf->method)->runcode; // Start with first instruction
 
 	// Return the thread
 	setTop(th, 1);
@@ -47,8 +47,7 @@ int context_frames(Value th) {
 	CallInfo *ci = context->curmethod;
 	// Heisenberg perspective: Do not include frame for this call
 	int nframes = context==th? 0 : 1;
-	while ((ci=ci->previous) != NULL)
-		nframes++;
+	nframes += ci - context->calls;
 	pushValue(th, anInt(nframes));
 	return 1;
 }
@@ -58,9 +57,7 @@ CallInfo* context_getCI(Value th, Value context, Aint frame) {
 	// Heisenberg perspective: Do not include frame for this call
 	if (context==th)
 		frame++;
-	while (frame-- && ci!=NULL)
-		ci=ci->previous;
-	return ci;
+	return frame >= 0 && frame <= ci - ((ThreadInfo*)context)->calls? ci - frame : NULL;
 }
 
 /** Retrieve method at designated frame */
@@ -46,6 +46,16 @@ int vm_log(Value th) {
 	return 0;
 }
 
+/** Return how hot a bytecode method must be before it is translated to native code (0 = never).
+ * If an Integer is passed, it becomes the new threshold (0 turns off native code). */
+int vm_jit(Value th) {
+	Value threshold = anInt(vm(th)->jitthreshold);
+	if (getTop(th)>1 && isInt(getLocal(th,1)) && toAint(getLocal(th,1))>=0)
+		vm(th)->jitthreshold = (Auint) toAint(getLocal(th,1));
+	pushValue(th, threshold);
+	return 1;
+}
+
 /** Initialize the List type */
 void core_vm_init(Value th) {
 	vmlit(TypeListc) = pushType(th, vmlit(TypeObject), 4);
@@ -55,6 +65,8 @@ void core_vm_init(Value th) {
 		popProperty(th, 0, "Print");
 		pushCMethod(th, vm_log);
 		popProperty(th, 0, "Log");
+		pushCMethod(th, vm_jit);
+		popProperty(th, 0, "Jit");
 	popGloVar(th, "Vm");
 	return;
 }
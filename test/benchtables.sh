@@ -0,0 +1,31 @@
+#!/bin/sh
+# Build testavm once with each hashed-table engine, run "testavm bench" with both,
+# and print each benchmark's timings side by side (run from the repository's root).
+#
+#   test/benchtables.sh [extra compiler flags]
+#
+# The library and the benchmark are compiled together with the same flags, so
+# testbench.cpp always agrees with the library on how TblInfo is laid out.
+# The Swiss-table engine is only available on x86-64.
+
+set -e
+CXX=${CXX:-g++}
+SOURCES="src/avmlib/*.cpp src/acorn/*.cpp src/core/*.cpp test/*.cpp"
+OUT=$(mktemp -d)
+trap 'rm -rf "$OUT"' EXIT
+
+for engine in swiss chained; do
+	if [ $engine = chained ]; then flags=-DAVM_NOSWISSTABLE; else flags=; fi
+	echo "Building the $engine engine..."
+	$CXX -O2 -w -fpermissive $flags "$@" -Iinclude -Iinclude/avm -Iinclude/acorn $SOURCES -o "$OUT/testavm-$engine"
+	(cd test && "$OUT/testavm-$engine" bench </dev/null) >"$OUT/$engine.txt"
+done
+
+# Timed lines end in a unit; the label fills the first 34 columns
+awk 'FNR==NR { if ($NF=="ns/op" || $NF=="us") swiss[substr($0,1,34)] = $(NF-1); next }
+	FNR==1 { printf "%-34s %12s %12s %14s\n", "", "swiss", "chained", "swiss/chained" }
+	$NF=="ns/op" || $NF=="us" {
+		label = substr($0,1,34)
+		printf "%-34s %9.2f %-2s %9.2f %-2s %13.2fx\n", label, swiss[label], $NF=="us"? "us" : "ns",
+			$(NF-1), $NF=="us"? "us" : "ns", ($(NF-1)>0? swiss[label]/$(NF-1) : 0)
+	}' "$OUT/swiss.txt" "$OUT/chained.txt"
@@ -17,6 +17,7 @@ void testGen(void);
 void testType(void);
 void testLang(void);
 void testCore(void);
+void testBench(void);
 
 void testAll(void) {
 	testCapi();
@@ -33,7 +34,10 @@ int main(int argc, char **argv) {
 	freopen("acornvm.log", "w", stderr);
 
 	printf("Testing %d-bit %s\n", AVM_ARCH, AVM_RELEASE);
-	testAll();
+	if (argc > 1 && strcmp(argv[1], "bench")==0)
+		testBench();
+	else
+		testAll();
 	// testGen();
 	
 	// Arbitrary pause so we see results in Visual Studio
@@ -0,0 +1,261 @@
+/* Benchmark the Acorn Virtual Machine's hashed tables, string hashing and short-lived allocations (run as: testavm bench).
+ *
+ * test/benchtables.sh builds it with each hashed-table engine and compares their timings.
+ * It includes avm_table.h, so it must be compiled with the same AVM_ flags as the library.
+ *
+ * This source file is not part of avm - Acorn Virtual Machine.
+*/
+
+#define AVM_LIBRARY_STATIC
+#include <avm.h>
+#include <avm_config.h>
+#include <avm/avm_table.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+using namespace avm;
+#endif
+
+#define NKEYS 1000		// Keys in the symbol and pointer tables
+#define ROUNDS 1000		// Times each lookup benchmark looks up every key
+#define NINTS 100000	// Keys in the integer table
+#define NSTRS 20000		// Strings in each string hashing corpus
+
+static void report(const char *what, float secs, long ops) {
+	printf("  %-32s %8.2f ms %8.2f ns/op\n", what, secs*1000.f, secs*1e9f/ops);
+}
+
+/* Fill array with NKEYS distinct symbols whose names start with prefix */
+static void benchSymbols(Value th, Value keys, const char *prefix) {
+	char name[32];
+	for (int i=0; i<NKEYS; i++) {
+		sprintf(name, "%s%d", prefix, i);
+		arrSet(th, keys, i, pushSym(th, name));
+		popValue(th);
+	}
+}
+
+static int cmphash(const void *a, const void *b) {
+	AuintIdx x = *(const AuintIdx*)a, y = *(const AuintIdx*)b;
+	return x<y? -1 : x>y;
+}
+
+/* Hash a corpus of NSTRS strings (made by format from two numbers), reporting how many
+ * hashes collide, then time interning each string as a symbol and looking it up again */
+static void benchStrHash(Value th, const char *what, const char *format) {
+	static char strs[NSTRS][128];
+	static AuintIdx hashes[NSTRS];
+	char label[64];
+	int64_t start;
+	for (int i=0; i<NSTRS; i++)
+		sprintf(strs[i], format, i/100, i%100);
+
+	start = vmStartTimer();
+	for (int r=0; r<10; r++)
+		for (int i=0; i<NSTRS; i++)
+			hashes[i] = tblCalcStrHash(strs[i], strlen(strs[i]), 0x5eed);
+	float secs = vmEndTimer(start);
+	qsort(hashes, NSTRS, sizeof(AuintIdx), cmphash);
+	int ncoll = 0;
+	for (int i=1; i<NSTRS; i++)
+		if (hashes[i]==hashes[i-1])
+			ncoll++;
+	printf("  %s (e.g. %s): %d of %d hashes collide\n", what, strs[NSTRS-1], ncoll, NSTRS);
+	sprintf(label, "%s: hash", what);
+	report(label, secs, 10L*NSTRS);
+
+	// Time each new symbol alone, to catch the slowest (one that grows the symbol table,
+	// as the garbage collector is stopped meanwhile)
+	Value syms = pushArray(th, aNull, NSTRS);
+	float worst = 0.f;
+	mem_gcstop(th);
+	secs = 0.f;
+	for (int i=0; i<NSTRS; i++) {
+		start = vmStartTimer();
+		arrSet(th, syms, i, pushSym(th, strs[i]));
+		float onesecs = vmEndTimer(start);
+		secs += onesecs;
+		if (onesecs > worst)
+			worst = onesecs;
+		popValue(th);
+	}
+	mem_gcstart(th);
+	sprintf(label, "%s: new symbol", what);
+	report(label, secs, NSTRS);
+	sprintf(label, "%s: slowest new symbol", what);
+	printf("  %-32s %8.2f us\n", label, worst*1e6f);
+	start = vmStartTimer();
+	for (int r=0; r<10; r++)
+		for (int i=0; i<NSTRS; i++) {
+			pushSym(th, strs[i]);
+			popValue(th);
+		}
+	sprintf(label, "%s: existing symbol", what);
+	report(label, vmEndTimer(start), 10L*NSTRS);
+	popValue(th);
+}
+
+void testBench(void) {
+	Value th = newVM();
+	Value found = aNull;
+	int64_t start;
+
+#ifdef AVM_SWISSTABLE
+	printf("Benchmarking Swiss-table engine\n");
+#else
+	printf("Benchmarking chained scatter table engine\n");
+#endif
+
+	// Resource URLs share long prefixes; identifiers are short
+	benchStrHash(th, "urls", "http://www.acornworlds.com/worlds/meadow/regions/region%03d/scenes/scene%02d/world.acn");
+	benchStrHash(th, "identifiers", "tileHeight%dx%d");
+
+	Value syms = pushArray(th, aNull, NKEYS);
+	benchSymbols(th, syms, "key");
+	Value others = pushArray(th, aNull, NKEYS);
+	benchSymbols(th, others, "other");
+	Value ptrs = pushArray(th, aNull, NKEYS);
+	for (int i=0; i<NKEYS; i++) {
+		arrSet(th, ptrs, i, pushArray(th, aNull, 0));
+		popValue(th);
+	}
+
+	// Build tables one key at a time, from empty
+	start = vmStartTimer();
+	for (int r=0; r<ROUNDS/10; r++) {
+		Value tbl = pushTbl(th, aNull, 0);
+		for (int i=0; i<NKEYS; i++)
+			tblSet(th, tbl, arrGet(th, syms, i), anInt(i));
+		popValue(th);
+	}
+	report("symbol keys: grow and insert", vmEndTimer(start), (long)NKEYS*(ROUNDS/10));
+
+	Value symtbl = pushTbl(th, aNull, 0);
+	for (int i=0; i<NKEYS; i++)
+		tblSet(th, symtbl, arrGet(th, syms, i), anInt(i));
+	start = vmStartTimer();
+	for (int r=0; r<ROUNDS; r++)
+		for (int i=0; i<NKEYS; i++)
+			found = tblGet(th, symtbl, arrGet(th, syms, i));
+	report("symbol keys: get (hit)", vmEndTimer(start), (long)NKEYS*ROUNDS);
+	start = vmStartTimer();
+	for (int r=0; r<ROUNDS; r++)
+		for (int i=0; i<NKEYS; i++)
+			found = tblGet(th, symtbl, arrGet(th, others, i));
+	report("symbol keys: get (miss)", vmEndTimer(start), (long)NKEYS*ROUNDS);
+
+	Value ptrtbl = pushTbl(th, aNull, 0);
+	for (int i=0; i<NKEYS; i++)
+		tblSet(th, ptrtbl, arrGet(th, ptrs, i), anInt(i));
+	start = vmStartTimer();
+	for (int r=0; r<ROUNDS; r++)
+		for (int i=0; i<NKEYS; i++)
+			found = tblGet(th, ptrtbl, arrGet(th, ptrs, i));
+	report("pointer keys: get (hit)", vmEndTimer(start), (long)NKEYS*ROUNDS);
+
+	// Text keys by content: separate but equal Text values, as parsed data would have
+	Value texts = pushArray(th, aNull, NKEYS);
+	Value textkeys = pushArray(th, aNull, NKEYS);
+	for (int i=0; i<NKEYS; i++) {
+		arrSet(th, texts, i, pushString(th, aNull, toStr(arrGet(th, syms, i))));
+		popValue(th);
+		arrSet(th, textkeys, i, pushString(th, aNull, toStr(arrGet(th, syms, i))));
+		popValue(th);
+	}
+	Value texttbl = pushTextTbl(th, aNull, 0);
+	for (int i=0; i<NKEYS; i++)
+		tblSet(th, texttbl, arrGet(th, texts, i), anInt(i));
+	start = vmStartTimer();
+	for (int r=0; r<ROUNDS; r++)
+		for (int i=0; i<NKEYS; i++)
+			found = tblGet(th, texttbl, arrGet(th, textkeys, i));
+	report("text keys: get (hit)", vmEndTimer(start), (long)NKEYS*ROUNDS);
+	start = vmStartTimer();
+	for (int r=0; r<ROUNDS; r++)
+		for (int i=0; i<NKEYS; i++) {
+			Value text = arrGet(th, textkeys, i);
+			found = tblGet(th, symtbl, pushSyml(th, toStr(text), getSize(text)));
+			popValue(th);
+		}
+	report("text as symbol keys: get (hit)", vmEndTimer(start), (long)NKEYS*ROUNDS);
+
+	Value inttbl = pushTbl(th, aNull, 0);
+	start = vmStartTimer();
+	for (int i=0; i<NINTS; i++)
+		tblSet(th, inttbl, anInt(i*7), anInt(i));
+	report("integer keys: grow and insert", vmEndTimer(start), NINTS);
+	start = vmStartTimer();
+	for (int r=0; r<10; r++)
+		for (int i=0; i<NINTS; i++)
+			found = tblGet(th, inttbl, anInt(i*7));
+	report("integer keys: get (hit)", vmEndTimer(start), 10L*NINTS);
+	start = vmStartTimer();
+	for (int r=0; r<10; r++)
+		for (Value key = tblNext(inttbl, aNull); key!=aNull; key = tblNext(inttbl, key))
+			found = key;
+	report("integer keys: tblNext traversal", vmEndTimer(start), 10L*NINTS);
+
+	// Dense Integer keys, like grid tiles
+	Value gridtbl = pushTbl(th, aNull, 0);
+	start = vmStartTimer();
+	for (int i=0; i<NINTS; i++)
+		tblSet(th, gridtbl, anInt(i), anInt(i));
+	report("dense integer keys: insert", vmEndTimer(start), NINTS);
+	start = vmStartTimer();
+	for (int r=0; r<10; r++)
+		for (int i=0; i<NINTS; i++)
+			found = tblGet(th, gridtbl, anInt(i));
+	report("dense integer keys: get", vmEndTimer(start), 10L*NINTS);
+	start = vmStartTimer();
+	for (int r=0; r<10; r++)
+		for (Value key = tblNext(gridtbl, aNull); key!=aNull; key = tblNext(gridtbl, key))
+			found = key;
+	report("dense integer keys: tblNext", vmEndTimer(start), 10L*NINTS);
+
+	// Integer keys spread out, as hashing sees them when they are not consecutive
+	Value scattbl = pushTbl(th, aNull, 0);
+	start = vmStartTimer();
+	for (int i=0; i<NINTS; i++)
+		tblSet(th, scattbl, anInt((i*2654435761u) & 0x3fffffff), anInt(i));
+	report("scattered integer keys: insert", vmEndTimer(start), NINTS);
+	start = vmStartTimer();
+	for (int r=0; r<10; r++)
+		for (int i=0; i<NINTS; i++)
+			found = tblGet(th, scattbl, anInt((i*2654435761u) & 0x3fffffff));
+	report("scattered integer keys: get", vmEndTimer(start), 10L*NINTS);
+
+	// Keep a sliding window of 100 keys: every add is paired with a remove
+	Value churn = pushTbl(th, aNull, 0);
+	start = vmStartTimer();
+	for (int i=0; i<NINTS*10; i++) {
+		tblSet(th, churn, anInt(i), anInt(i));
+		if (i>=100)
+			tblRemove(th, churn, anInt(i-100));
+	}
+	report("integer keys: add/remove churn", vmEndTimer(start), 10L*NINTS);
+
+	// Short-lived temporaries, as most allocations are: each is garbage as soon as it is popped
+	start = vmStartTimer();
+	for (int i=0; i<NINTS*10; i++) {
+		pushString(th, aNull, "a short-lived Text");
+		pushArray(th, aNull, 4);
+		popValue(th);
+		popValue(th);
+	}
+	report("temporaries: Text and List", vmEndTimer(start), 10L*NINTS);
+	Value keep = pushArray(th, aNull, NINTS/10); // Every 100th survives
+	start = vmStartTimer();
+	for (int i=0; i<NINTS*10; i++) {
+		Value text = pushString(th, aNull, "a short-lived Text");
+		if (i%100 == 0)
+			arrSet(th, keep, (i/100)%(NINTS/10), text);
+		popValue(th);
+	}
+	report("temporaries: 1% survive", vmEndTimer(start), 10L*NINTS);
+
+	if (found == syms) // Keep the lookups from being optimized away
+		puts("");
+	vmClose(th);
+}
@@ -5,6 +5,7 @@
 
 #define AVM_LIBRARY_STATIC
 #include <avm.h>
+#include <acorn.h> // For tests that look inside the VM (property caches, bytecode verification)
 #include <stdio.h>
 #include <string.h>
 
@@ -65,6 +66,35 @@ int decmixin(Value th) {
 	pushValue(th, anInt(toAint(getLocal(th, 0))-1));
 	return 1;
 }
+int incmixin(Value th) {
+	pushValue(th, anInt(toAint(getLocal(th, 0))+1));
+	return 1;
+}
+
+/* Push a bytecode method with the given code, 4 registers and one literal (7).
+ * Return whether it passes verification. */
+bool pushTestBMethod(Value th, const Instruction *code, AuintIdx size) {
+	Value meth;
+	newBMethod(th, &meth);
+	pushValue(th, meth);
+	BMethodInfo *bm = (BMethodInfo*) meth;
+	mem_reallocvector(th, bm->code, 0, size, Instruction);
+	bm->avail = bm->size = size;
+	memcpy(bm->code, code, size*sizeof(Instruction));
+	mem_reallocvector(th, bm->lits, 0, 1, Value);
+	bm->litsz = bm->nbrlits = 1;
+	bm->lits[0] = anInt(7);
+	bm->maxstacksize = 4;
+	bm->nbrlocals = 1;
+	return methodVerify(th, meth);
+}
+
+/* Call the method on top of the stack, returning its one result */
+Value callTestBMethod(Value th) {
+	pushValue(th, aNull); // self
+	getCall(th, 1, 1);
+	return popValue(th);
+}
 
 enum stkit {
 	true1,
@@ -155,6 +185,56 @@ void testCapi(void) {
 	t(getSize(getLocal(th, true1))==4, "getSize('true')==4");
 	t(isEqStr(getLocal(th, false1),"false"), "isEqStr(sym'false','false')");
 	t(strcmp(toStr(getLocal(th, true2)),"true")==0, "toStr('true')=='true'");
+	{
+		// Interning enough symbols to move them to larger symbol tables several times over
+		char name[16];
+		int n, found = 0;
+		Value syms = pushArray(th, aNull, 2000);
+		for (n=0; n<2000; n++) {
+			sprintf(name, "sym%d", n);
+			arrSet(th, syms, n, pushSym(th, name));
+			popValue(th);
+		}
+		for (n=0; n<2000; n++) {
+			sprintf(name, "sym%d", n);
+			found += isSame(pushSym(th, name), arrGet(th, syms, n));
+			popValue(th);
+		}
+		t(found==2000, "Re-interned symbols are the same");
+		t(isSame(pushSym(th, "true"), getLocal(th, true1)), "'true' is still interned");
+		popValue(th);
+		popValue(th);
+	}
+	{
+		// Enough short-lived temporaries for many collections. Every 200th Text and Symbol
+		// is kept in Lists that have become old, so must survive by way of the write barrier.
+		char name[16];
+		int n, found = 0;
+		Value keep = pushArray(th, aNull, 100);
+		Value keepsyms = pushArray(th, aNull, 100);
+		for (n=0; n<20000; n++) {
+			sprintf(name, "temp%d", n);
+			Value text = pushString(th, aNull, name);
+			Value sym = pushSym(th, name);
+			pushArray(th, aNull, 4);
+			if (n%200 == 0) {
+				arrSet(th, keep, n/200, text);
+				arrSet(th, keepsyms, n/200, sym);
+			}
+			popValue(th);
+			popValue(th);
+			popValue(th);
+		}
+		for (n=0; n<100; n++) {
+			sprintf(name, "temp%d", n*200);
+			found += isEqStr(arrGet(th, keep, n), name);
+			found += isSame(pushSym(th, name), arrGet(th, keepsyms, n));
+			popValue(th);
+		}
+		t(found==200, "Kept temporaries survive collections intact");
+		popValue(th);
+		popValue(th);
+	}
 
 	// String API tests
 	t(!isStr(aNull), "!isSym(aNull)");
@@ -261,6 +341,60 @@ void testCapi(void) {
 	tblRemove(th, getLocal(th, tbl1), getLocal(th, name)); // Delete 'name'
 	t(!tblHas(th, getLocal(th, tbl1), getLocal(th, name)), "!tblHas(tbl1, 'name')");
 	t(getSize(getLocal(th, tbl1))==4, "getSize(tbl1)==4"); // Now have 4 entries
+	Value tbl2 = pushTbl(th, aNull, 0); // Many adds and removes, leaving deleted entries behind
+	for (int n=0; n<1000; n++) {
+		tblSet(th, tbl2, anInt(n), anInt(-n));
+		if (n>=10)
+			tblRemove(th, tbl2, anInt(n-10));
+	}
+	int nkeys = 0;
+	for (iter = tblNext(tbl2, aNull); iter!=aNull; iter = tblNext(tbl2, iter))
+		nkeys++;
+	t(getSize(tbl2)==10 && nkeys==10, "getSize(tbl2)==10 after churn");
+	t(tblGet(th, tbl2, anInt(995))==anInt(-995) && !tblHas(th, tbl2, anInt(989)), "tblGet(tbl2, 995)==-995 after churn");
+	popValue(th);
+	tbl2 = pushTbl(th, aNull, 0); // Dense Integer keys end up in the array part, so iterate in order
+	for (int n=0; n<100; n++)
+		tblSet(th, tbl2, anInt(n), anInt(n));
+	tblSet(th, tbl2, anInt(-5), aTrue);
+	tblRemove(th, tbl2, anInt(1));
+	t(getSize(tbl2)==100 && !tblHas(th, tbl2, anInt(1)) && tblGet(th, tbl2, anInt(-5))==aTrue, "getSize(tbl2)==100");
+	t(tblNext(tbl2, aNull)==anInt(0) && tblNext(tbl2, anInt(0))==anInt(2) && tblNext(tbl2, anInt(99))==anInt(-5), "tblNext(tbl2) in Integer key order");
+	popValue(th);
+	tbl2 = pushTextTbl(th, aNull, 0); // Text keys match by content
+	Value text1 = pushString(th, aNull, "tileHeight");
+	Value text2 = pushString(th, aNull, "tile");
+	strAppend(th, text2, "Height", 6);
+	tblSet(th, tbl2, text1, anInt(32));
+	t(tblGet(th, tbl2, text2)==anInt(32) && getSize(tbl2)==1, "TextTbl: equal Text is the same key");
+	tblSet(th, tbl2, text2, anInt(48));
+	t(tblGet(th, tbl2, text1)==anInt(48) && getSize(tbl2)==1, "TextTbl: set through equal Text");
+	strAppend(th, text2, "s", 1); // Changed contents hash anew
+	t(!tblHas(th, tbl2, text2) && !tblHas(th, getLocal(th, tbl1), text1), "TextTbl: changed Text, and Index by identity");
+	tblRemove(th, tbl2, text2);
+	t(getSize(tbl2)==1, "TextTbl: removing another key leaves it");
+	strSub(th, text2, 10, 1, NULL, 0);
+	tblRemove(th, tbl2, text2);
+	t(getSize(tbl2)==0, "TextTbl: remove by content");
+	t(str_hash(th, text1)==tblCalcStrHash("tileHeight", 10, vm(th)->hashseed), "TextTbl: keys hash with the VM's random seed");
+	popValue(th);
+	popValue(th);
+	popValue(th);
+	Value obj = pushType(th, aNull, 0); // Objects keep symbol keys in a shared shape
+	tblSet(th, obj, getLocal(th, name), getLocal(th, george));
+	tblSet(th, obj, getLocal(th, weight), anInt(80));
+	tblSet(th, obj, getLocal(th, name), getLocal(th, peter));
+	t(getSize(obj)==2 && tblGet(th, obj, getLocal(th, name))==getLocal(th, peter), "shaped tblGet(obj, 'name')=='Peter'");
+	t(tblNext(obj, aNull)==getLocal(th, name) && tblNext(obj, getLocal(th, name))==getLocal(th, weight), "shaped tblNext in key order");
+	tblRemove(th, obj, getLocal(th, name)); // No longer shaped
+	t(getSize(obj)==1 && !tblHas(th, obj, getLocal(th, name)), "unshaped tblRemove(obj, 'name')");
+	t(tblGet(th, obj, getLocal(th, weight))==anInt(80), "unshaped tblGet(obj, 'weight')==80");
+	obj = pushType(th, aNull, 0);
+	tblSet(th, obj, getLocal(th, name), getLocal(th, george));
+	tblSet(th, obj, anInt(7), aTrue); // Not a symbol key, so no longer shaped
+	t(getSize(obj)==2 && tblGet(th, obj, getLocal(th, name))==getLocal(th, george), "unshaped tblGet(obj, 'name')=='George'");
+	popValue(th);
+	popValue(th);
 	//pushSerialized(th, getLocal(th, tbl1));
 	//puts(toStr(popValue(th)));
 	//pushGloVar(th, "Resource");
@@ -342,6 +476,74 @@ void testCapi(void) {
 	pushValue(th, anInt(4));
 	getCall(th, 1, 1);
 	t(popValue(th) == aNull, "popValue(th) == aNull)");
+	pushValue(th, mixin); // A property found missing is found once added
+	pushCMethod(th, incmixin);
+	popProperty(th, getTop(th)-2, "++");
+	popValue(th);
+	pushSym(th, "++");
+	pushValue(th, anInt(4));
+	getCall(th, 1, 1);
+	t(popValue(th) == anInt(5), "popValue(th) == anInt(5)) after adding missing property");
+
+	// Property caches: writing an instance's field must not invalidate cached lookups in its type
+	{
+		int top = getTop(th);
+		Value cls = pushType(th, aNull, 4);
+		Value obj = pushType(th, cls, 4);
+		Value area = pushSym(th, "area");
+		Value x = pushSym(th, "x");
+		Value meth;
+		newBMethod(th, &meth);
+		pushValue(th, meth);
+		tblSet(th, cls, area, anInt(1));
+		PropCache pc;
+		pc.epoch = 0;
+		pc.nbrentries = 0;
+		t(methGetPropCached(th, (BMethodInfo*)meth, &pc, obj, area)==anInt(1), "Cached lookup finds type's property");
+		pc.entry[0].val = anInt(2); // Only a cache hit returns this
+		tblSet(th, obj, x, anInt(5));
+		t(methGetPropCached(th, (BMethodInfo*)meth, &pc, obj, area)==anInt(2), "Property cache hit survives an instance field write");
+		t(methGetPropCached(th, (BMethodInfo*)meth, &pc, obj, x)==anInt(5), "Cached lookup finds instance's field");
+		tblSet(th, obj, x, anInt(6));
+		t(methGetPropCached(th, (BMethodInfo*)meth, &pc, obj, x)==anInt(6), "Cached lookup finds instance's changed field");
+		Value missing = pushSym(th, "missing");
+		Value y = pushSym(th, "y");
+		t(getProperty(th, obj, missing)==aNull, "Type's lookup cache remembers a missing property");
+		tblTypeCache(th, cls)->entry[sym_info(missing)->hash & (AVM_TYPECACHESIZE-1)].val = anInt(4); // Only a cache hit returns this
+		tblSet(th, obj, y, anInt(7));
+		t(getProperty(th, obj, missing)==anInt(4), "Type's cached miss survives an instance field write");
+		tblSet(th, cls, area, anInt(3));
+		t(methGetPropCached(th, (BMethodInfo*)meth, &pc, obj, area)==anInt(3), "Changing the type invalidates property caches");
+		t(getProperty(th, obj, missing)==aNull, "Changing the type empties its lookup cache");
+		setTop(th, top);
+	}
+
+	// Bytecode verification: malformed methods are refused rather than run
+	{
+		int top = getTop(th);
+		Instruction good[] = {BCINS_ABx(OpLoadLit, 1, 0), BCINS_ABC(OpReturn, 1, 1, 0)};
+		t(pushTestBMethod(th, good, 2), "Well-formed method verifies");
+		t(callTestBMethod(th)==anInt(7), "Verified method runs");
+		Instruction badreg[] = {BCINS_ABx(OpLoadLit, 4, 0), BCINS_ABC(OpReturn, 4, 1, 0)};
+		t(!pushTestBMethod(th, badreg, 2), "Register beyond stack size fails verification");
+		t(callTestBMethod(th)==aNull, "Method with bad register is not run");
+		Instruction badlit[] = {BCINS_ABx(OpLoadLit, 1, 1), BCINS_ABC(OpReturn, 1, 1, 0)};
+		t(!pushTestBMethod(th, badlit, 2), "Literal beyond literals fails verification");
+		t(callTestBMethod(th)==aNull, "Method with bad literal is not run");
+		Instruction badjump[] = {BCINS_ABx(OpLoadLit, 1, 0), (Instruction)BCINS_AJ(OpJTrue, 1, 1), BCINS_ABC(OpReturn, 1, 1, 0)};
+		t(!pushTestBMethod(th, badjump, 3), "Jump past the end fails verification");
+		t(callTestBMethod(th)==aNull, "Method with bad jump is not run");
+		Instruction noextra[] = {BCINS_ABx(OpLoadLit, 1, 0), BCINS_ABC(OpGetProp, 1, 0, 0), BCINS_ABC(OpReturn, 1, 1, 0)};
+		t(!pushTestBMethod(th, noextra, 3), "Missing extra argument fails verification");
+		t(callTestBMethod(th)==aNull, "Method missing extra argument is not run");
+		Instruction badstd[] = {BCINS_ABC(OpLoadStd, 1, 0, 255), BCINS_ABC(OpReturn, 1, 1, 0)};
+		t(!pushTestBMethod(th, badstd, 2), "Unknown standard symbol fails verification");
+		t(callTestBMethod(th)==aNull, "Method with unknown standard symbol is not run");
+		Instruction badclo[] = {BCINS_ABC(OpSetClosure, 0, 1, 0), BCINS_ABC(OpReturn, 0, 1, 0)};
+		t(!pushTestBMethod(th, badclo, 2), "Closure method as closure variable fails verification");
+		t(callTestBMethod(th)==aNull, "Method overwriting closure's method is not run");
+		setTop(th, top);
+	}
 
 	// Serialization
 	pushSerialized(th, aNull);